@@ -0,0 +1,443 @@
+// Benchmark.cpp
+// Evaluations-to-target benchmark of RunNomad on the stand-in host
+//
+// Runs every benchmark problem with every option set, then records the
+// evaluations and wall time each run needed to reach target objective levels.
+// A target for tolerance tau is f_L + tau * (f_0 - f_L), where f_0 is the
+// objective at the starting point and f_L is the best of the known optimum
+// and the best value found by any run. Writes to the output directory:
+//   results.csv              evaluations and seconds per problem/options/tau,
+//                            and the target objective they were measured to
+//   performance_profile.csv  fraction of problems solved within alpha times
+//                            the evaluations of the best option set
+//   data_profile.csv         fraction of problems solved within kappa
+//                            simplex gradients, i.e. kappa * (n + 1) evals
+// Usage: Benchmark [--out DIR] [--max-evals N] [--baseline results.csv]
+//                  [--daemon SOCKET] [--transport]
+//                  [--change-latency SECONDS]
+// With --baseline, results are compared against an earlier results.csv and
+// the exit code is 1 if any target got worse. The comparison uses the target
+// objectives of the baseline, as f_L moves whenever any run improves on it.
+// With --daemon, every solve is requested from a solve daemon listening on
+// SOCKET in this process. With --transport, the stand-in host runs in a
+// separate process and is called over the shared-memory transport. With
+// --change-latency, each recalculation waits SECONDS per variable changed
+// since the previous one, so the seconds in results.csv show the effect of
+// evaluation order; evaluations alone cannot.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkProblems.hpp"
+#include "EvaluationBackend.hpp"
+#include "NomadInterface.hpp"
+#include "SolveDaemon.hpp"
+#include "StandInHost.hpp"
+
+namespace OPENSOLVER {
+
+const double TOLERANCES[] = {1e-1, 1e-3, 1e-5, 1e-7};
+const int NUM_TOLERANCES = 4;
+
+const double PERFORMANCE_ALPHAS[] = {1, 1.5, 2, 3, 4, 6, 8, 16, 32, 64};
+const int NUM_PERFORMANCE_ALPHAS = 10;
+
+const double DATA_KAPPAS[] = {1, 2, 5, 10, 20, 50, 100, 200, 500};
+const int NUM_DATA_KAPPAS = 9;
+
+// Targets are written in full so a baseline can be measured to them again
+const int TARGET_PRECISION = 17;
+const int DEFAULT_PRECISION = 6;
+
+// A run may use this much more than the baseline before it is a regression
+const double REGRESSION_FACTOR = 1.1;
+
+// Time allowed for the solve daemon to start listening
+const int DAEMON_START_ATTEMPTS = 100;
+const int DAEMON_START_POLL_MS = 50;
+
+struct OptionSet {
+  std::string               name;
+  std::vector<std::string>  options;
+  bool                      parallelBackends;
+  bool                      useWarmstart;
+};
+
+struct RunResult {
+  std::vector<StandInEvaluation>  trace;
+  int                             retval;
+};
+
+// Evaluations and seconds to reach a target, evals is -1 if never reached
+struct TargetResult {
+  int     evals;
+  double  seconds;
+  double  target;   // The objective value that counts as reached
+};
+
+// A row of an earlier results.csv
+struct BaselineResult {
+  int     evals;
+  double  target;   // NaN if the file predates the target column
+};
+
+std::vector<OptionSet> GetOptionSets() {
+  std::vector<OptionSet> sets;
+  OptionSet set;
+  set.parallelBackends = false;
+  set.useWarmstart = true;
+
+  set.name = "default";
+  sets.push_back(set);
+
+  set.name = "auto_tune";
+  set.options.assign(1, "AUTO_TUNE yes");
+  sets.push_back(set);
+
+  set.name = "ortho_2n";
+  set.options.assign(1, "DIRECTION_TYPE ORTHO 2N");
+  sets.push_back(set);
+
+  set.name = "no_model_search";
+  set.options.assign(1, "MODEL_SEARCH no");
+  sets.push_back(set);
+
+  set.name = "background";
+  set.options.assign(1, "BACKGROUND_SOLVE yes");
+  sets.push_back(set);
+
+  // Compared with auto_tune, which uses blocks
+  set.name = "single_point";
+  set.options.assign(1, "AUTO_TUNE yes");
+  set.options.push_back("EVALUATION_BLOCK_SIZE 1");
+  sets.push_back(set);
+
+  // Compared with default, which evaluates one point at a time
+  set.name = "blocks";
+  set.options.assign(1, "EVALUATION_BLOCK_SIZE 16");
+  sets.push_back(set);
+
+  set.name = "stall_100";
+  set.options.assign(1, "STALL_WINDOW 100");
+  sets.push_back(set);
+
+  set.name = "aggregate_sum";
+  set.options.assign(1, "CONSTRAINT_AGGREGATION SUM");
+  sets.push_back(set);
+
+  // Cold starts ignore the problem's starting point
+  set.name = "cold_midpoint";
+  set.options.assign(1, "INITIAL_DESIGN MIDPOINT");
+  set.useWarmstart = false;
+  sets.push_back(set);
+
+  set.name = "cold_lhs";
+  set.options.assign(1, "INITIAL_DESIGN LHS");
+  sets.push_back(set);
+
+  set.name = "cold_sobol";
+  set.options.assign(1, "INITIAL_DESIGN SOBOL");
+  sets.push_back(set);
+
+  set.name = "psd_4";
+  set.useWarmstart = true;
+  set.options.assign(1, "PSD_WORKERS 4");
+  set.parallelBackends = true;
+  sets.push_back(set);
+
+  return sets;
+}
+
+std::string GetKey(const std::string& problem, const std::string& options,
+                   double tau) {
+  std::ostringstream key;
+  key << problem << "," << options << "," << tau;
+  return key.str();
+}
+
+TargetResult FindTarget(const std::vector<StandInEvaluation>& trace,
+                        double target) {
+  TargetResult result = {-1, 0, target};
+  for (size_t i = 0; i < trace.size(); ++i) {
+    if (trace[i].feasible && trace[i].objective <= target) {
+      result.evals = static_cast<int>(i) + 1;
+      result.seconds = trace[i].seconds;
+      break;
+    }
+  }
+  return result;
+}
+
+// Reads results.csv from an earlier run into a map from key to result
+bool ReadBaseline(const std::string& path,
+                  std::map<std::string, BaselineResult>* results) {
+  std::ifstream file(path.c_str());
+  if (!file) {
+    return false;
+  }
+  std::string line;
+  std::getline(file, line);  // Header
+  while (std::getline(file, line)) {
+    std::vector<std::string> fields;
+    std::istringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+      fields.push_back(field);
+    }
+    if (fields.size() < 4) {
+      continue;
+    }
+    double tau = strtod(fields[2].c_str(), nullptr);
+    BaselineResult result;
+    result.evals = atoi(fields[3].c_str());
+    result.target = (fields.size() >= 6) ? strtod(fields[5].c_str(), nullptr)
+                                         : std::nan("");
+    (*results)[GetKey(fields[0], fields[1], tau)] = result;
+  }
+  return true;
+}
+
+int RunBenchmark(int argc, char* argv[]) {
+  std::string outDir = ".";
+  std::string baselinePath;
+  std::string daemonSocket;
+  int maxEvals = 1000;
+  double changeLatency = 0;
+  bool useTransport = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--transport") {
+      useTransport = true;
+    } else if (i + 1 == argc) {
+      std::cerr << "Missing value for argument: " << arg << std::endl;
+      return EXIT_FAILURE;
+    } else if (arg == "--out") {
+      outDir = argv[++i];
+    } else if (arg == "--max-evals") {
+      maxEvals = atoi(argv[++i]);
+    } else if (arg == "--baseline") {
+      baselinePath = argv[++i];
+    } else if (arg == "--daemon") {
+      daemonSocket = argv[++i];
+    } else if (arg == "--change-latency") {
+      changeLatency = strtod(argv[++i], nullptr);
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<StandInProblem> problems = GetBenchmarkProblems();
+  std::vector<OptionSet> sets = GetOptionSets();
+  std::ostringstream budget;
+  budget << "MAX_BB_EVAL " << maxEvals;
+
+  std::thread daemon;
+  if (!daemonSocket.empty()) {
+    daemon = std::thread(RunSolveDaemon, daemonSocket, RunNomad, 0);
+    std::string reply;
+    int attempts = 0;
+    while (SendDaemonRequest(daemonSocket, "VERSION", &reply) !=
+           DAEMON_REPLIED) {
+      if (++attempts == DAEMON_START_ATTEMPTS) {
+        std::cerr << "Solve daemon did not start on " << daemonSocket
+                  << std::endl;
+        daemon.detach();
+        return EXIT_FAILURE;
+      }
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(DAEMON_START_POLL_MS));
+    }
+  }
+
+  // runs[p][s] is the result of problem p with option set s
+  std::vector<std::vector<RunResult> > runs(problems.size());
+  for (size_t p = 0; p < problems.size(); ++p) {
+    for (size_t s = 0; s < sets.size(); ++s) {
+      std::vector<std::string> options = sets[s].options;
+      options.push_back(budget.str());
+      std::string logPath = outDir + "/" + problems[p].name + "." +
+                            sets[s].name + ".log";
+
+      StartStandInSolve(&problems[p], options, logPath,
+                        sets[s].useWarmstart, 0, changeLatency);
+      SetBackendFactory(sets[s].parallelBackends ? CreateStandInBackend
+                                                 : nullptr);
+      RunResult run;
+      std::string reply;
+      if (useTransport && !StartStandInTransport()) {
+        std::cerr << "Could not start the stand-in host process" << std::endl;
+        run.retval = ERROR_OCCURED;
+      } else if (daemonSocket.empty()) {
+        run.retval = RunNomad();
+      } else if (SendDaemonRequest(daemonSocket, "SOLVE", &reply) ==
+                 DAEMON_REPLIED) {
+        run.retval = atoi(reply.c_str());
+      } else {
+        run.retval = ERROR_OCCURED;
+      }
+      if (useTransport && !StopStandInTransport()) {
+        run.retval = ERROR_OCCURED;
+      }
+      run.trace = GetStandInTrace();
+      runs[p].push_back(run);
+      SetBackendFactory(nullptr);
+
+      std::cout << problems[p].name << " / " << sets[s].name << ": "
+                << run.trace.size() << " evaluations, return value "
+                << run.retval << std::endl;
+    }
+  }
+
+  if (daemon.joinable()) {
+    std::string reply;
+    SendDaemonRequest(daemonSocket, "QUIT", &reply);
+    daemon.join();
+  }
+
+  // targets[t][p][s] is the target result for tolerance t
+  std::vector<std::vector<std::vector<TargetResult> > > targets(
+      NUM_TOLERANCES, std::vector<std::vector<TargetResult> >(problems.size()));
+  for (size_t p = 0; p < problems.size(); ++p) {
+    std::vector<double> outputs(problems[p].numCons);
+    problems[p].evaluate(problems[p].startingX.data(), outputs.data());
+    double f0 = outputs[0];
+
+    double fL = problems[p].optimum;
+    for (size_t s = 0; s < sets.size(); ++s) {
+      const std::vector<StandInEvaluation>& trace = runs[p][s].trace;
+      for (size_t i = 0; i < trace.size(); ++i) {
+        if (trace[i].feasible) {
+          fL = std::min(fL, trace[i].objective);
+        }
+      }
+    }
+    // Guard against a starting point that is already optimal or an error
+    if (!(f0 > fL)) {
+      f0 = fL + 1;
+    }
+
+    for (int t = 0; t < NUM_TOLERANCES; ++t) {
+      double target = fL + TOLERANCES[t] * (f0 - fL);
+      for (size_t s = 0; s < sets.size(); ++s) {
+        targets[t][p].push_back(FindTarget(runs[p][s].trace, target));
+      }
+    }
+  }
+
+  std::ofstream results((outDir + "/results.csv").c_str());
+  results << "problem,options,tau,evals,seconds,target" << std::endl;
+  for (int t = 0; t < NUM_TOLERANCES; ++t) {
+    for (size_t p = 0; p < problems.size(); ++p) {
+      for (size_t s = 0; s < sets.size(); ++s) {
+        const TargetResult& r = targets[t][p][s];
+        results << problems[p].name << "," << sets[s].name << ","
+                << TOLERANCES[t] << "," << r.evals << "," << r.seconds << ","
+                << std::setprecision(TARGET_PRECISION) << r.target
+                << std::setprecision(DEFAULT_PRECISION) << std::endl;
+      }
+    }
+  }
+
+  std::ofstream performance((outDir + "/performance_profile.csv").c_str());
+  performance << "tau,options,alpha,fraction" << std::endl;
+  std::ofstream data((outDir + "/data_profile.csv").c_str());
+  data << "tau,options,kappa,fraction" << std::endl;
+  const double numProblems = static_cast<double>(problems.size());
+  for (int t = 0; t < NUM_TOLERANCES; ++t) {
+    for (size_t s = 0; s < sets.size(); ++s) {
+      for (int a = 0; a < NUM_PERFORMANCE_ALPHAS; ++a) {
+        int solved = 0;
+        for (size_t p = 0; p < problems.size(); ++p) {
+          int best = -1;
+          for (size_t other = 0; other < sets.size(); ++other) {
+            int evals = targets[t][p][other].evals;
+            if (evals > 0 && (best < 0 || evals < best)) {
+              best = evals;
+            }
+          }
+          int evals = targets[t][p][s].evals;
+          if (evals > 0 && evals <= PERFORMANCE_ALPHAS[a] * best) {
+            ++solved;
+          }
+        }
+        performance << TOLERANCES[t] << "," << sets[s].name << ","
+                    << PERFORMANCE_ALPHAS[a] << "," << solved / numProblems
+                    << std::endl;
+      }
+      for (int k = 0; k < NUM_DATA_KAPPAS; ++k) {
+        int solved = 0;
+        for (size_t p = 0; p < problems.size(); ++p) {
+          int evals = targets[t][p][s].evals;
+          if (evals > 0 &&
+              evals <= DATA_KAPPAS[k] * (problems[p].numVars + 1)) {
+            ++solved;
+          }
+        }
+        data << TOLERANCES[t] << "," << sets[s].name << "," << DATA_KAPPAS[k]
+             << "," << solved / numProblems << std::endl;
+      }
+    }
+  }
+
+  if (baselinePath.empty()) {
+    return EXIT_SUCCESS;
+  }
+
+  std::map<std::string, BaselineResult> baseline;
+  if (!ReadBaseline(baselinePath, &baseline)) {
+    std::cerr << "Could not read baseline " << baselinePath << std::endl;
+    return EXIT_FAILURE;
+  }
+  int improved = 0;
+  int regressed = 0;
+  for (int t = 0; t < NUM_TOLERANCES; ++t) {
+    for (size_t p = 0; p < problems.size(); ++p) {
+      for (size_t s = 0; s < sets.size(); ++s) {
+        std::string key = GetKey(problems[p].name, sets[s].name,
+                                 TOLERANCES[t]);
+        std::map<std::string, BaselineResult>::const_iterator it =
+            baseline.find(key);
+        if (it == baseline.end()) {
+          continue;
+        }
+        // Measure this run to the same target as the baseline
+        int before = it->second.evals;
+        int after = std::isnan(it->second.target)
+                    ? targets[t][p][s].evals
+                    : FindTarget(runs[p][s].trace, it->second.target).evals;
+        bool worse = (before > 0 && (after < 0 ||
+                                     after > REGRESSION_FACTOR * before));
+        bool better = (after > 0 && (before < 0 ||
+                                     before > REGRESSION_FACTOR * after));
+        if (worse || better) {
+          std::cout << (worse ? "REGRESSED " : "IMPROVED  ") << key << ": "
+                    << before << " -> " << after << " evaluations"
+                    << std::endl;
+        }
+        regressed += worse ? 1 : 0;
+        improved += better ? 1 : 0;
+      }
+    }
+  }
+  std::cout << improved << " targets improved, " << regressed
+            << " targets regressed against the baseline" << std::endl;
+  return regressed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+}  // namespace OPENSOLVER
+
+int main(int argc, char* argv[]) {
+  return OPENSOLVER::RunBenchmark(argc, argv);
+}
@@ -0,0 +1,203 @@
+// BenchmarkProblems.cpp
+
+#include "BenchmarkProblems.hpp"
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "NomadInterface.hpp"
+
+namespace OPENSOLVER {
+
+const double KNAPSACK_VALUES[] =  {10, 13, 7, 8, 12, 9, 4, 11, 6, 5};
+const double KNAPSACK_WEIGHTS[] = {5, 6, 3, 4, 7, 5, 2, 6, 3, 3};
+const double KNAPSACK_CAPACITY = 20;
+const int KNAPSACK_SIZE = 10;
+
+const double INTEGER_TARGETS[] = {3, -2, 1.5, 0, 4.5, -3};
+const int INTEGER_SIZE = 6;
+
+void Rosenbrock(int n, const double* x, double* outputs) {
+  double f = 0;
+  for (int i = 0; i + 1 < n; ++i) {
+    double a = x[i + 1] - x[i] * x[i];
+    double b = 1 - x[i];
+    f += 100 * a * a + b * b;
+  }
+  outputs[0] = f;
+}
+
+void Rosenbrock2(const double* x, double* outputs) {
+  Rosenbrock(2, x, outputs);
+}
+
+void Rosenbrock5(const double* x, double* outputs) {
+  Rosenbrock(5, x, outputs);
+}
+
+// Like a workbook's quick mode: the same valley, but less accurate away from
+// the optimum
+void Rosenbrock5Quick(const double* x, double* outputs) {
+  double f = 0;
+  for (int i = 0; i < 4; ++i) {
+    double a = x[i + 1] - x[i] * x[i];
+    double b = 1 - x[i];
+    f += 80 * a * a + 1.5 * b * b;
+  }
+  outputs[0] = f;
+}
+
+void ShiftedSphere10(const double* x, double* outputs) {
+  double f = 0;
+  for (int i = 0; i < 10; ++i) {
+    f += (x[i] - 1) * (x[i] - 1);
+  }
+  outputs[0] = f;
+}
+
+void StyblinskiTang4(const double* x, double* outputs) {
+  double f = 0;
+  for (int i = 0; i < 4; ++i) {
+    f += x[i] * x[i] * x[i] * x[i] - 16 * x[i] * x[i] + 5 * x[i];
+  }
+  outputs[0] = f / 2;
+}
+
+void IntegerQuadratic6(const double* x, double* outputs) {
+  double f = 0;
+  for (int i = 0; i < INTEGER_SIZE; ++i) {
+    f += (x[i] - INTEGER_TARGETS[i]) * (x[i] - INTEGER_TARGETS[i]);
+  }
+  outputs[0] = f;
+}
+
+void Knapsack10(const double* x, double* outputs) {
+  double value = 0;
+  double weight = 0;
+  for (int i = 0; i < KNAPSACK_SIZE; ++i) {
+    value += KNAPSACK_VALUES[i] * x[i];
+    weight += KNAPSACK_WEIGHTS[i] * x[i];
+  }
+  outputs[0] = -value;
+  outputs[1] = weight - KNAPSACK_CAPACITY;
+}
+
+// Hock-Schittkowski problem 21
+void Hs21(const double* x, double* outputs) {
+  outputs[0] = 0.01 * x[0] * x[0] + x[1] * x[1] - 100;
+  outputs[1] = -(10 * x[0] - x[1] - 10);
+}
+
+// Hock-Schittkowski problem 35
+void Hs35(const double* x, double* outputs) {
+  outputs[0] = 9 - 8 * x[0] - 6 * x[1] - 4 * x[2] + 2 * x[0] * x[0] +
+               2 * x[1] * x[1] + x[2] * x[2] + 2 * x[0] * x[1] +
+               2 * x[0] * x[2];
+  outputs[1] = x[0] + x[1] + 2 * x[2] - 3;
+}
+
+void LinearOverDisk(const double* x, double* outputs) {
+  outputs[0] = x[0] + x[1];
+  outputs[1] = x[0] * x[0] + x[1] * x[1] - 1;
+}
+
+// Like a workbook that gives #NUM! outside the unit disk
+void ErrorOutsideDisk(const double* x, double* outputs) {
+  if (x[0] * x[0] + x[1] * x[1] > 1) {
+    outputs[0] = std::numeric_limits<double>::quiet_NaN();
+  } else {
+    outputs[0] = (x[0] - 1) * (x[0] - 1) + (x[1] - 1) * (x[1] - 1);
+  }
+}
+
+StandInProblem MakeProblem(const std::string& name, int numVars, int numCons,
+                           double lower, double upper, double start,
+                           int varType, double optimum,
+                           void (*evaluate)(const double*, double*)) {
+  StandInProblem problem;
+  problem.name = name;
+  problem.numVars = numVars;
+  problem.numObjs = 1;
+  problem.numCons = numCons;
+  problem.lowerBounds.assign(numVars, lower);
+  problem.upperBounds.assign(numVars, upper);
+  problem.startingX.assign(numVars, start);
+  problem.varTypes.assign(numVars, varType);
+  problem.optimum = optimum;
+  problem.evaluate = evaluate;
+  problem.surrogate = nullptr;
+  return problem;
+}
+
+// Finds the knapsack optimum by enumeration so the data can't go stale
+double SolveKnapsack() {
+  double best = 0;
+  for (int mask = 0; mask < (1 << KNAPSACK_SIZE); ++mask) {
+    double value = 0;
+    double weight = 0;
+    for (int i = 0; i < KNAPSACK_SIZE; ++i) {
+      if (mask & (1 << i)) {
+        value += KNAPSACK_VALUES[i];
+        weight += KNAPSACK_WEIGHTS[i];
+      }
+    }
+    if (weight <= KNAPSACK_CAPACITY && value > best) {
+      best = value;
+    }
+  }
+  return -best;
+}
+
+std::vector<StandInProblem> GetBenchmarkProblems() {
+  std::vector<StandInProblem> problems;
+
+  // Bound-constrained
+  StandInProblem rosenbrock2 = MakeProblem("rosenbrock2", 2, 1, -5, 10, 0,
+                                           CONTINUOUS, 0, Rosenbrock2);
+  rosenbrock2.startingX[0] = -1.2;
+  rosenbrock2.startingX[1] = 1;
+  problems.push_back(rosenbrock2);
+  StandInProblem rosenbrock5 = MakeProblem("rosenbrock5", 5, 1, -5, 10, -1.2,
+                                           CONTINUOUS, 0, Rosenbrock5);
+  rosenbrock5.surrogate = Rosenbrock5Quick;
+  problems.push_back(rosenbrock5);
+  problems.push_back(MakeProblem("sphere10", 10, 1, -5, 5, 3, CONTINUOUS, 0,
+                                 ShiftedSphere10));
+  problems.push_back(MakeProblem("styblinski_tang4", 4, 1, -5, 5, 0,
+                                 CONTINUOUS, -39.16616570 * 4,
+                                 StyblinskiTang4));
+
+  // Integer and binary
+  problems.push_back(MakeProblem("integer_quadratic6", INTEGER_SIZE, 1, -10,
+                                 10, 0, INTEGER, 0.5, IntegerQuadratic6));
+  // The weight limit is cheap to compute, so it is declared as a pre-check
+  StandInProblem knapsack10 = MakeProblem("knapsack10", KNAPSACK_SIZE, 2, 0, 1,
+                                          0, BINARY, SolveKnapsack(),
+                                          Knapsack10);
+  knapsack10.precheckOutputs.push_back(1);
+  problems.push_back(knapsack10);
+
+  // Constrained
+  StandInProblem hs21 = MakeProblem("hs21", 2, 2, -50, 50, 0, CONTINUOUS,
+                                    -99.96, Hs21);
+  hs21.lowerBounds[0] = 2;
+  hs21.startingX[0] = 2;
+  hs21.startingX[1] = -1;
+  problems.push_back(hs21);
+  problems.push_back(MakeProblem("hs35", 3, 2, 0, 1e30, 0.5, CONTINUOUS,
+                                 1.0 / 9, Hs35));
+  problems.push_back(MakeProblem("linear_over_disk", 2, 2, -2, 2, 0,
+                                 CONTINUOUS, -std::sqrt(2.0), LinearOverDisk));
+
+  // Excel errors outside the feasible region
+  const double diskGap = 1 - std::sqrt(0.5);
+  problems.push_back(MakeProblem("error_outside_disk", 2, 1, -2, 2, 0,
+                                 CONTINUOUS, 2 * diskGap * diskGap,
+                                 ErrorOutsideDisk));
+
+  return problems;
+}
+
+}  // namespace OPENSOLVER
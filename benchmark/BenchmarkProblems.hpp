@@ -0,0 +1,25 @@
+// BenchmarkProblems.hpp
+// Fixed suite of test problems for the convergence benchmark
+
+#ifndef BENCHMARK_BENCHMARKPROBLEMS_H_
+#define BENCHMARK_BENCHMARKPROBLEMS_H_
+
+#include <vector>
+
+#include "StandInHost.hpp"
+
+namespace OPENSOLVER {
+
+/**
+ * Gets the benchmark problems
+ *
+ * The suite covers bound-constrained, integer and binary, and constrained
+ * problems, plus one whose objective is an Excel error outside a region.
+ * The optimum of each problem is known.
+ * @return The problems, in a fixed order
+ */
+std::vector<StandInProblem> GetBenchmarkProblems();
+
+}  // namespace OPENSOLVER
+
+#endif  // BENCHMARK_BENCHMARKPROBLEMS_H_
@@ -0,0 +1,120 @@
+// AdaptiveReplication.cpp
+
+#include "AdaptiveReplication.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace OPENSOLVER {
+
+// A point is near the incumbent if its first read is within this many noise
+// standard deviations of the incumbent objective
+const double NEAR_INCUMBENT_SDS = 2.0;
+
+// Replication stops once the mean is this many standard errors away from
+// the incumbent objective
+const double DECISION_SDS = 2.0;
+
+AdaptiveReplication::AdaptiveReplication(int numCons, int numObjs,
+                                         int maxReplicates, int budget,
+                                         double tolerance) :
+    _numCons(numCons),
+    _numObjs(numObjs),
+    _maxReplicates(maxReplicates),
+    _budget(budget),
+    _tolerance(tolerance),
+    _count(0),
+    _failed(false),
+    _sums(numCons),
+    _objMean(0),
+    _objM2(0),
+    _pooledSumSquares(0),
+    _pooledDegrees(0),
+    _numReplicated(0),
+    _numExtraReads(0) {}
+
+void AdaptiveReplication::Begin(const double* values) {
+  _count = 0;
+  _failed = false;
+  std::fill(_sums.begin(), _sums.end(), 0.0);
+  _objMean = 0;
+  _objM2 = 0;
+  Add(values);
+}
+
+void AdaptiveReplication::Add(const double* values) {
+  if (_count > 0) {
+    ++_numExtraReads;
+  }
+
+  // A read with an Excel error ends replication, keeping the reads so far
+  for (int i = 0; i < _numCons; ++i) {
+    if (std::isnan(values[i])) {
+      _failed = true;
+      if (_count == 0) {
+        // Keep the failed first read so it is passed on unchanged
+        std::copy(values, values + _numCons, _sums.begin());
+        _count = 1;
+      }
+      return;
+    }
+  }
+
+  ++_count;
+  for (int i = 0; i < _numCons; ++i) {
+    _sums[i] += values[i];
+  }
+
+  // Welford's update for the objective variance
+  if (_numObjs > 0) {
+    double delta = values[0] - _objMean;
+    _objMean += delta / _count;
+    _objM2 += delta * (values[0] - _objMean);
+  }
+}
+
+bool AdaptiveReplication::NeedsMore(const double* bestObjective) const {
+  if (_numObjs == 0 || _failed || _count >= _maxReplicates ||
+      _numExtraReads >= _budget) {
+    return false;
+  }
+
+  if (_count == 1) {
+    // Only replicate points that could compete with the incumbent
+    if (bestObjective == nullptr || _pooledDegrees == 0) {
+      return true;
+    }
+    return _objMean <= *bestObjective + NEAR_INCUMBENT_SDS * GetNoiseEstimate();
+  }
+
+  double stdError = std::sqrt(_objM2 / (_count - 1) / _count);
+  if (stdError <= _tolerance * std::max(1.0, std::fabs(_objMean))) {
+    return false;
+  }
+  if (bestObjective != nullptr &&
+      std::fabs(_objMean - *bestObjective) >= DECISION_SDS * stdError) {
+    return false;
+  }
+  return true;
+}
+
+void AdaptiveReplication::Finish(double* values) {
+  if (_count > 1) {
+    ++_numReplicated;
+    _pooledSumSquares += _objM2;
+    _pooledDegrees += _count - 1;
+  }
+  for (int i = 0; i < _numCons; ++i) {
+    values[i] = _sums[i] / _count;
+  }
+}
+
+double AdaptiveReplication::GetNoiseEstimate() const {
+  if (_pooledDegrees == 0) {
+    return -1;
+  }
+  return std::sqrt(_pooledSumSquares / _pooledDegrees);
+}
+
+}  // namespace OPENSOLVER
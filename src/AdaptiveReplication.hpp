@@ -0,0 +1,75 @@
+// AdaptiveReplication.hpp
+// Averages repeated reads of noisy (RAND-driven) models near the incumbent
+//
+// After the first read of a point, the point is replicated if its objective
+// could compete with the incumbent given the noise seen so far. Replication
+// continues until the mean objective is precise enough or clearly better or
+// worse than the incumbent, up to a per-point and a global limit.
+
+#ifndef SRC_ADAPTIVEREPLICATION_H_
+#define SRC_ADAPTIVEREPLICATION_H_
+
+#include <vector>
+
+namespace OPENSOLVER {
+
+class AdaptiveReplication {
+ public:
+  /**
+   * @param numCons The number of constraints in the model (inc. objectives)
+   * @param numObjs The number of objectives, which come first
+   * @param maxReplicates The most reads of any single point
+   * @param budget The most extra reads over the whole solve
+   * @param tolerance Relative standard error at which to stop replicating
+   */
+  AdaptiveReplication(int numCons, int numObjs, int maxReplicates, int budget,
+                      double tolerance);
+
+  // Starts a new point with its first read
+  void Begin(const double* values);
+
+  /**
+   * Decides whether the current point needs another read
+   *
+   * @param bestObjective Pointer to the incumbent objective (NULL if none)
+   * @return True if the point should be read again
+   */
+  bool NeedsMore(const double* bestObjective) const;
+
+  // Adds another read of the current point
+  void Add(const double* values);
+
+  // Writes the mean of all reads of the current point into values
+  void Finish(double* values);
+
+  int GetNumReplicated() const { return _numReplicated; }
+  int GetNumExtraReads() const { return _numExtraReads; }
+
+  // Pooled estimate of the standard deviation of the objective (-1 if none)
+  double GetNoiseEstimate() const;
+
+ private:
+  int                  _numCons;
+  int                  _numObjs;
+  int                  _maxReplicates;
+  int                  _budget;
+  double               _tolerance;
+
+  // Running sums for the current point
+  int                  _count;
+  bool                 _failed;
+  std::vector<double>  _sums;
+  double               _objMean;
+  double               _objM2;
+
+  // Pooled variance of the objective over all replicated points
+  double               _pooledSumSquares;
+  int                  _pooledDegrees;
+
+  int                  _numReplicated;
+  int                  _numExtraReads;
+};
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_ADAPTIVEREPLICATION_H_
@@ -0,0 +1,338 @@
+// BinaryEnumeration.cpp
+
+#include "BinaryEnumeration.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EvaluationBackend.hpp"
+#include "ExcelCallbacks.hpp"
+#include "NomadInterface.hpp"
+
+namespace OPENSOLVER {
+
+// Incumbent and stopping state shared between the workers
+class EnumerationShared {
+ public:
+  EnumerationShared(int m, int numObjs, int maxTime) :
+      _m(m),
+      _numObjs(numObjs),
+      _maxTime(maxTime),
+      _start(std::chrono::steady_clock::now()),
+      _hasIncumbent(false),
+      _feasible(false),
+      _f(0),
+      _h(0),
+      _bbEval(0),
+      _numPruned(0),
+      _stopped(false),
+      _stopReason(NOMAD::NO_STOP) {}
+
+  // Returns true if workers should stop, stopping them if out of time
+  bool CheckStop() {
+    if (_stopped) {
+      return true;
+    }
+    if (_maxTime > 0 && std::chrono::steady_clock::now() - _start >=
+                            std::chrono::seconds(_maxTime)) {
+      Stop(NOMAD::MAX_TIME_REACHED);
+      return true;
+    }
+    return false;
+  }
+
+  void Stop(NOMAD::stop_type reason) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_stopped) {
+      _stopReason = reason;
+      _stopped = true;
+    }
+  }
+
+  void Fail(const std::string& error) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_error.empty()) {
+      _error = error;
+    }
+    if (!_stopped) {
+      _stopReason = NOMAD::ERROR;
+      _stopped = true;
+    }
+  }
+
+  // Gets the incumbent objective to show in the host status
+  bool GetStatus(double* bestSolution, bool* feasibility) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    *bestSolution = _f;
+    *feasibility = _feasible;
+    return _hasIncumbent;
+  }
+
+  void AddPruned() { ++_numPruned; }
+
+  // Counts an evaluation and keeps it if it beats the incumbent
+  void Merge(const std::vector<double>& x, const std::vector<double>& outputs) {
+    ++_bbEval;
+    double f = 0;
+    double h = 0;
+    for (int i = 0; i < _m; ++i) {
+      if (std::isnan(outputs[i])) {
+        return;
+      }
+      if (i < _numObjs) {
+        f = outputs[i];
+      } else if (outputs[i] > 0) {
+        h += outputs[i] * outputs[i];
+      }
+    }
+    bool feasible = (h == 0);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    bool improved;
+    if (!_hasIncumbent) {
+      improved = true;
+    } else if (feasible != _feasible) {
+      improved = feasible;
+    } else {
+      improved = feasible ? (f < _f) : (h < _h);
+    }
+    if (improved) {
+      _x = x;
+      _f = f;
+      _h = h;
+      _feasible = feasible;
+      _hasIncumbent = true;
+    }
+
+    // Without an objective any feasible point is optimal
+    if (feasible && _numObjs == 0 && !_stopped) {
+      _stopReason = NOMAD::FEAS_REACHED;
+      _stopped = true;
+    }
+  }
+
+  void FillResult(EnumerationResult* result) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    result->hasSolution = _hasIncumbent;
+    result->feasible = _hasIncumbent && _feasible;
+    result->x = _x;
+    result->f = _f;
+    result->stopReason = _stopReason;
+    result->proven = (_stopReason == NOMAD::NO_STOP ||
+                      _stopReason == NOMAD::FEAS_REACHED);
+    result->bbEval = _bbEval;
+    result->numPruned = _numPruned;
+  }
+
+  const std::string& GetError() const { return _error; }
+
+ private:
+  int                    _m;
+  int                    _numObjs;
+  int                    _maxTime;
+  std::chrono::steady_clock::time_point _start;
+
+  std::mutex             _mutex;
+  bool                   _hasIncumbent;
+  std::vector<double>    _x;
+  bool                   _feasible;
+  double                 _f;
+  double                 _h;
+  std::atomic<int>       _bbEval;
+  std::atomic<int>       _numPruned;
+  std::atomic<bool>      _stopped;
+  NOMAD::stop_type       _stopReason;
+  std::string            _error;
+};
+
+/**
+ * Evaluates the points with Gray-code indices in [begin, end)
+ *
+ * @param hostCalls The dispatcher, if this worker evaluates on the host and
+ *                  so can use the pre-checks, or nullptr
+ */
+void RunEnumerationWorker(uint32_t begin, uint32_t end,
+                          const std::vector<int>& freeVars,
+                          const std::vector<double>& fixedValues, int m,
+                          const std::vector<int>* precheckOutputs,
+                          EnumerationShared* shared,
+                          EvaluationBackend* backend,
+                          EvaluationDispatcher* hostCalls) {
+  const int n = static_cast<int>(fixedValues.size());
+  std::vector<double> x(fixedValues);
+  std::vector<double> outputs(m);
+  const int numPrecheck = (precheckOutputs != nullptr && hostCalls != nullptr)
+                          ? static_cast<int>(precheckOutputs->size()) : 0;
+  std::vector<double> precheckValues(numPrecheck);
+
+  try {
+    for (uint32_t k = begin; k < end && !shared->CheckStop(); ++k) {
+      uint32_t code = k ^ (k >> 1);
+      for (size_t j = 0; j < freeVars.size(); ++j) {
+        x[freeVars[j]] = (code >> j) & 1;
+      }
+
+      double bestValue;
+      bool feasibility;
+      const double* bestSol = nullptr;
+      if (shared->GetStatus(&bestValue, &feasibility)) {
+        bestSol = &bestValue;
+      }
+
+      EXCEL_RC rc;
+      bool pruned = false;
+      if (numPrecheck > 0) {
+        // Both steps in one call, so other workers can't move the variables
+        // in between
+        rc = hostCalls->Call([&] {
+          EXCEL_RC precheckRc = PrecheckX(x.data(), n, bestSol, feasibility,
+                                          numPrecheck, precheckValues.data());
+          if (precheckRc != SUCCESS) {
+            return precheckRc;
+          }
+          for (int i = 0; i < numPrecheck; ++i) {
+            if (!(precheckValues[i] <= 0)) {
+              pruned = true;
+              return static_cast<EXCEL_RC>(SUCCESS);
+            }
+          }
+          return ReevaluateX(m, outputs.data());
+        });
+      } else {
+        rc = backend->Evaluate(x.data(), n, m, bestSol, feasibility,
+                               outputs.data());
+      }
+
+      if (rc != SUCCESS) {
+        if (GetErrorCode(rc) == ESC_ABORT) {
+          shared->Stop(NOMAD::CTRL_C);
+        } else {
+          shared->Fail(GetExcelCallbackErrorMessage(rc));
+        }
+        return;
+      }
+      if (pruned) {
+        shared->AddPruned();
+      } else {
+        shared->Merge(x, outputs);
+      }
+    }
+  }
+  catch (std::exception& e) {
+    shared->Fail(e.what());
+  }
+}
+
+int CountEnumerationVariables(const std::vector<double>& lowerBounds,
+                              const std::vector<double>& upperBounds,
+                              const std::vector<int>& varTypes) {
+  int numFree = 0;
+  for (size_t i = 0; i < varTypes.size(); ++i) {
+    if (varTypes[i] != BINARY) {
+      return -1;
+    }
+    if (lowerBounds[i] <= 0 && upperBounds[i] >= 1) {
+      ++numFree;
+    }
+  }
+  return numFree;
+}
+
+EnumerationResult RunBinaryEnumeration(const std::vector<double>& lowerBounds,
+                                       const std::vector<double>& upperBounds,
+                                       int numCons, int numObjs, int maxTime,
+                                       const EnumerationSettings& settings,
+                                       const NOMAD::Display& out) {
+  const int n = static_cast<int>(lowerBounds.size());
+  std::vector<int> freeVars;
+  std::vector<double> fixedValues(n);
+  for (int i = 0; i < n; ++i) {
+    if (lowerBounds[i] <= 0 && upperBounds[i] >= 1) {
+      freeVars.push_back(i);
+    } else {
+      fixedValues[i] = (lowerBounds[i] > 0) ? 1 : 0;
+    }
+  }
+  if (freeVars.size() > static_cast<size_t>(MAX_ENUMERATION_VARIABLES)) {
+    throw std::runtime_error("too many variables to enumerate");
+  }
+
+  EnumerationShared shared(numCons, numObjs, maxTime);
+  const uint32_t numPoints = 1u << freeVars.size();
+  const int maxWorkers = static_cast<int>(
+      std::min<uint32_t>(std::max(settings.numWorkers, 1), numPoints));
+
+  // Only one worker evaluates on the host. Several would interleave their
+  // calls, so consecutive recalculations would come from different ranges
+  // and differ in many variables, losing the point of the Gray code.
+  HostBackend host;
+  EvaluationDispatcher dispatcher(&host);
+  std::vector<std::unique_ptr<EvaluationBackend> > ownedBackends;
+  bool hasHostWorker = false;
+  for (int w = 0; w < maxWorkers; ++w) {
+    EvaluationBackend* backend = CreateWorkerBackend(w);
+    if (backend != nullptr) {
+      ownedBackends.emplace_back(backend);
+    } else if (!hasHostWorker) {
+      hasHostWorker = true;
+    }
+  }
+  const int numWorkers = static_cast<int>(ownedBackends.size()) +
+                         (hasHostWorker ? 1 : 0);
+
+  std::vector<std::thread> workers;
+  std::atomic<int> running(numWorkers);
+  for (int w = 0; w < numWorkers; ++w) {
+    EvaluationBackend* backend = &dispatcher;
+    EvaluationDispatcher* hostCalls = &dispatcher;
+    if (w < static_cast<int>(ownedBackends.size())) {
+      backend = ownedBackends[w].get();
+      hostCalls = nullptr;
+    }
+    // Each worker takes a contiguous range of the Gray code
+    uint32_t begin = static_cast<uint32_t>(
+        static_cast<uint64_t>(numPoints) * w / numWorkers);
+    uint32_t end = static_cast<uint32_t>(
+        static_cast<uint64_t>(numPoints) * (w + 1) / numWorkers);
+    workers.emplace_back([&, begin, end, backend, hostCalls] {
+      RunEnumerationWorker(begin, end, freeVars, fixedValues, numCons,
+                           settings.precheckOutputs, &shared, backend,
+                           hostCalls);
+      if (--running == 0) {
+        dispatcher.Stop();
+      }
+    });
+  }
+
+  // Serve the workers' evaluations on this thread until they all finish
+  dispatcher.Serve();
+  for (size_t w = 0; w < workers.size(); ++w) {
+    workers[w].join();
+  }
+
+  if (!shared.GetError().empty()) {
+    throw std::runtime_error(shared.GetError());
+  }
+
+  EnumerationResult result;
+  shared.FillResult(&result);
+  out << endl << "Enumeration: " << numWorkers << " workers evaluated "
+      << result.bbEval << " and pruned " << result.numPruned << " of "
+      << numPoints << " points";
+  if (result.proven) {
+    out << ", the solution is optimal";
+  }
+  out << endl;
+  return result;
+}
+
+}  // namespace OPENSOLVER
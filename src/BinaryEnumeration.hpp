@@ -0,0 +1,84 @@
+// BinaryEnumeration.hpp
+// Exhaustive enumeration of small all-binary models
+//
+// When every variable is binary and there are only a few of them, visiting
+// every point is affordable and proves the optimum, where MADS would spend a
+// similar budget and could still miss it. Points are visited in Gray-code
+// order, so consecutive evaluations differ in exactly one variable and Excel
+// only recalculates the cells that depend on it. The code space is split
+// into contiguous ranges, one per worker thread, and evaluations go through
+// an EvaluationBackend per worker as in PSD-MADS. Only workers with their own
+// backend keep the one-variable steps, so at most one worker evaluates on
+// the host.
+//
+// Points can only be pruned when the host supplies pre-check outputs: a
+// point that violates one of them is skipped without a full recalculation.
+// Other constraints are only known after the full recalculation, so without
+// pre-check outputs every point is evaluated.
+
+#ifndef SRC_BINARYENUMERATION_H_
+#define SRC_BINARYENUMERATION_H_
+
+#include <vector>
+
+#include "nomad.hpp"
+
+namespace OPENSOLVER {
+
+// Most free variables we will enumerate, i.e. about a million points
+const int MAX_ENUMERATION_VARIABLES = 20;
+
+struct EnumerationSettings {
+  int                      numWorkers;       // Number of worker threads
+  const std::vector<int>*  precheckOutputs;  // nullptr if there are none
+};
+
+struct EnumerationResult {
+  bool                 hasSolution;
+  bool                 feasible;
+  std::vector<double>  x;
+  double               f;
+  bool                 proven;      // The solution is known to be optimal
+  NOMAD::stop_type     stopReason;  // NO_STOP unless stopped early
+  int                  bbEval;      // Full evaluations
+  int                  numPruned;   // Points rejected by a pre-check
+};
+
+/**
+ * Counts the variables that an enumeration would have to vary
+ *
+ * @param lowerBounds The lower bound of each variable
+ * @param upperBounds The upper bound of each variable
+ * @param varTypes The type of each variable, see VarType
+ * @return The number of binary variables that aren't fixed by their bounds,
+ *         or -1 if the model can't be enumerated because a variable isn't
+ *         binary
+ */
+int CountEnumerationVariables(const std::vector<double>& lowerBounds,
+                              const std::vector<double>& upperBounds,
+                              const std::vector<int>& varTypes);
+
+/**
+ * Evaluates every point of an all-binary model
+ *
+ * Must be called from the host thread, which serves the evaluations of the
+ * worker that uses the default backend. Only models with at most one
+ * objective can be enumerated.
+ * @param lowerBounds The lower bound of each variable
+ * @param upperBounds The upper bound of each variable
+ * @param numCons The number of outputs, including the objectives
+ * @param numObjs The number of objectives, 0 or 1
+ * @param maxTime Seconds after which to stop, or <= 0 for no limit
+ * @param settings The enumeration settings
+ * @param out The display for progress messages
+ * @return The best point found and whether it is proven optimal
+ */
+EnumerationResult RunBinaryEnumeration(const std::vector<double>& lowerBounds,
+                                       const std::vector<double>& upperBounds,
+                                       int numCons, int numObjs, int maxTime,
+                                       const EnumerationSettings& settings,
+                                       const NOMAD::Display& out);
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_BINARYENUMERATION_H_
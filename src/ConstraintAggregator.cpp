@@ -0,0 +1,62 @@
+// ConstraintAggregator.cpp
+
+#include "ConstraintAggregator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace OPENSOLVER {
+
+ConstraintAggregator::ConstraintAggregator(int numCons, int numObjs,
+                                           ConstraintAggregation type,
+                                           int numGroups) :
+    _numObjs(numObjs),
+    _numConstraints(numCons - numObjs),
+    _type(type),
+    _numGroups(std::max(0, std::min(numGroups, numCons - numObjs))) {}
+
+int ConstraintAggregator::GetGroupStart(int group) const {
+  // Spread the constraints as evenly as possible over the groups
+  return static_cast<int>(static_cast<int64_t>(group) * _numConstraints /
+                          _numGroups);
+}
+
+int ConstraintAggregator::GetGroup(int constraint) const {
+  int group = static_cast<int>(static_cast<int64_t>(constraint) *
+                               _numGroups / _numConstraints);
+  // The estimate can be off by one either way due to rounding
+  while (group + 1 < _numGroups && GetGroupStart(group + 1) <= constraint) {
+    ++group;
+  }
+  while (group > 0 && GetGroupStart(group) > constraint) {
+    --group;
+  }
+  return group;
+}
+
+void ConstraintAggregator::Aggregate(double* outputs) const {
+  double* constraints = outputs + _numObjs;
+  // Group g is written to constraints[g], which is never after its own
+  // range, so every group is read before it can be overwritten
+  for (int group = 0; group < _numGroups; ++group) {
+    int end = GetGroupStart(group + 1);
+    double value = (_type == SUM_AGGREGATION)
+                   ? 0 : -std::numeric_limits<double>::infinity();
+    for (int i = GetGroupStart(group); i < end; ++i) {
+      if (std::isnan(constraints[i])) {
+        value = std::numeric_limits<double>::quiet_NaN();
+        break;
+      }
+      if (_type == SUM_AGGREGATION) {
+        value += std::max(constraints[i], 0.0);
+      } else {
+        value = std::max(value, constraints[i]);
+      }
+    }
+    constraints[group] = value;
+  }
+}
+
+}  // namespace OPENSOLVER
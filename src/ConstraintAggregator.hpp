@@ -0,0 +1,64 @@
+// ConstraintAggregator.hpp
+// Combines groups of constraints into single outputs before they reach NOMAD
+//
+// Every constraint is an extreme barrier (EB) output, so NOMAD only needs to
+// know whether any of them is violated. Models with thousands of constraint
+// cells make every Eval_Point, and so the cache, large for no benefit. The
+// constraints are split into contiguous groups, and each group is given to
+// NOMAD as either its largest value or the sum of its violations. Both are
+// <= 0 exactly when every constraint in the group is satisfied.
+
+#ifndef SRC_CONSTRAINTAGGREGATOR_H_
+#define SRC_CONSTRAINTAGGREGATOR_H_
+
+namespace OPENSOLVER {
+
+enum ConstraintAggregation {
+  NO_AGGREGATION,
+  MAX_AGGREGATION,  // Largest constraint value in the group
+  SUM_AGGREGATION   // Sum of the positive constraint values in the group
+};
+
+class ConstraintAggregator {
+ public:
+  /**
+   * @param numCons The number of outputs, including the objectives
+   * @param numObjs The number of objectives, which come first
+   * @param type How each group is combined, not NO_AGGREGATION
+   * @param numGroups The number of groups, at most one per constraint
+   */
+  ConstraintAggregator(int numCons, int numObjs, ConstraintAggregation type,
+                       int numGroups);
+
+  // Number of outputs that NOMAD sees for each point
+  int GetNumOutputs() const { return _numObjs + _numGroups; }
+
+  int GetNumGroups() const { return _numGroups; }
+
+  // Gets the group that a constraint (counted from 0 after the objectives)
+  // belongs to
+  int GetGroup(int constraint) const;
+
+  /**
+   * Replaces the constraints with their group values, in place
+   *
+   * The objectives are left as they are and the group values follow them.
+   * A group is NaN if any of its constraints is.
+   * @param outputs The full outputs of a point
+   */
+  void Aggregate(double* outputs) const;
+
+ private:
+  // First constraint of a group, or the number of constraints for the group
+  // after the last
+  int GetGroupStart(int group) const;
+
+  int                    _numObjs;
+  int                    _numConstraints;
+  ConstraintAggregation  _type;
+  int                    _numGroups;
+};
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_CONSTRAINTAGGREGATOR_H_
@@ -0,0 +1,98 @@
+// EvaluationBackend.cpp
+
+#include "EvaluationBackend.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace OPENSOLVER {
+
+EXCEL_RC HostBackend::Evaluate(double* newVars, int numVars, int numCons,
+                               const double* bestSolution, bool feasibility,
+                               double* newCons) {
+  return EvaluateX(newVars, numVars, numCons, bestSolution, feasibility,
+                   newCons);
+}
+
+EvaluationDispatcher::EvaluationDispatcher(EvaluationBackend* host) :
+    _host(host),
+    _stopped(false) {}
+
+EXCEL_RC EvaluationDispatcher::Evaluate(double* newVars, int numVars,
+                                        int numCons,
+                                        const double* bestSolution,
+                                        bool feasibility, double* newCons) {
+  EvaluationBackend* host = _host;
+  return Call([=] {
+    return host->Evaluate(newVars, numVars, numCons, bestSolution,
+                          feasibility, newCons);
+  });
+}
+
+EXCEL_RC EvaluationDispatcher::Call(const std::function<EXCEL_RC()>& call) {
+  Request request = {&call, SUCCESS, false};
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_stopped) {
+    return EXCEL_API_ERROR;
+  }
+  _queue.push_back(&request);
+  _requestQueued.notify_one();
+  _requestDone.wait(lock, [&request] { return request.done; });
+  return request.rc;
+}
+
+void EvaluationDispatcher::Serve(int idlePeriodMs,
+                                 const std::function<void()>& onIdle) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  auto ready = [this] { return _stopped || !_queue.empty(); };
+  for (;;) {
+    if (onIdle) {
+      if (!_requestQueued.wait_for(lock,
+                                   std::chrono::milliseconds(idlePeriodMs),
+                                   ready)) {
+        lock.unlock();
+        onIdle();
+        lock.lock();
+        continue;
+      }
+    } else {
+      _requestQueued.wait(lock, ready);
+    }
+    if (_queue.empty()) {
+      return;
+    }
+    Request* request = _queue.front();
+    _queue.pop_front();
+
+    // Let other threads queue up more work while the host is busy
+    lock.unlock();
+    EXCEL_RC rc = (*request->call)();
+    lock.lock();
+
+    request->rc = rc;
+    request->done = true;
+    _requestDone.notify_all();
+  }
+}
+
+void EvaluationDispatcher::Stop() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _stopped = true;
+  _requestQueued.notify_all();
+}
+
+BackendFactory backendFactory = nullptr;
+
+void SetBackendFactory(BackendFactory factory) {
+  backendFactory = factory;
+}
+
+EvaluationBackend* CreateWorkerBackend(int workerIndex) {
+  return backendFactory == nullptr ? nullptr : backendFactory(workerIndex);
+}
+
+}  // namespace OPENSOLVER
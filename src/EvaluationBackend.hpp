@@ -0,0 +1,118 @@
+// EvaluationBackend.hpp
+// Evaluation backends that can be used from threads other than the host's
+//
+// The host callbacks in ExcelCallbacks.hpp may only be called from the thread
+// that started the solve. Worker threads evaluate through an
+// EvaluationBackend instead, which by default queues the evaluation to the
+// host thread with an EvaluationDispatcher. A different backend factory can
+// be installed to give each worker an independent backend, e.g. one stand-in
+// host per worker when running on Linux. The dispatcher can also run any
+// other host call, which lets the whole optimiser run off the host thread.
+
+#ifndef SRC_EVALUATIONBACKEND_H_
+#define SRC_EVALUATIONBACKEND_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "ExcelCallbacks.hpp"
+
+namespace OPENSOLVER {
+
+class EvaluationBackend {
+ public:
+  virtual ~EvaluationBackend() {}
+
+  // Conduct an evaluation iteration, with the same contract as EvaluateX
+  virtual EXCEL_RC Evaluate(double* newVars, int numVars, int numCons,
+                            const double* bestSolution, bool feasibility,
+                            double* newCons) = 0;
+};
+
+/**
+ * Backend that evaluates directly with the host callbacks
+ *
+ * Must only be used from the host thread.
+ */
+class HostBackend : public EvaluationBackend {
+ public:
+  EXCEL_RC Evaluate(double* newVars, int numVars, int numCons,
+                    const double* bestSolution, bool feasibility,
+                    double* newCons) override;
+};
+
+/**
+ * Backend that queues evaluations from any thread to the host thread
+ *
+ * Evaluate and Call block the calling thread until the host thread has run
+ * the request inside Serve.
+ */
+class EvaluationDispatcher : public EvaluationBackend {
+ public:
+  explicit EvaluationDispatcher(EvaluationBackend* host);
+
+  EXCEL_RC Evaluate(double* newVars, int numVars, int numCons,
+                    const double* bestSolution, bool feasibility,
+                    double* newCons) override;
+
+  /**
+   * Runs any host callback on the host thread
+   *
+   * @param call The callback to run
+   * @return The return code of the callback, or EXCEL_API_ERROR if the
+   *         dispatcher has already stopped
+   */
+  EXCEL_RC Call(const std::function<EXCEL_RC()>& call);
+
+  /**
+   * Runs queued requests on the calling thread until Stop is called
+   *
+   * @param idlePeriodMs How long to wait for a request before calling onIdle
+   * @param onIdle Called on this thread whenever no request has arrived for
+   *               idlePeriodMs, e.g. to check the host for an abort
+   */
+  void Serve(int idlePeriodMs = 0,
+             const std::function<void()>& onIdle = std::function<void()>());
+
+  // Makes Serve return once the queue is empty. Safe from any thread.
+  void Stop();
+
+ private:
+  struct Request {
+    const std::function<EXCEL_RC()>*  call;
+    EXCEL_RC                          rc;
+    bool                              done;
+  };
+
+  EvaluationBackend*       _host;
+  std::mutex               _mutex;
+  std::condition_variable  _requestQueued;
+  std::condition_variable  _requestDone;
+  std::deque<Request*>     _queue;
+  bool                     _stopped;
+};
+
+// Creates the backend for a worker thread, or returns nullptr to use the
+// host dispatcher. The caller owns the returned backend.
+typedef EvaluationBackend* (*BackendFactory)(int workerIndex);
+
+/**
+ * Installs the factory used to create backends for worker threads
+ *
+ * @param factory The factory to use, or nullptr to always use the dispatcher
+ */
+void SetBackendFactory(BackendFactory factory);
+
+/**
+ * Creates a backend for a worker thread using the installed factory
+ *
+ * @param workerIndex The index of the worker
+ * @return The new backend, or nullptr if the dispatcher should be used
+ */
+EvaluationBackend* CreateWorkerBackend(int workerIndex);
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_EVALUATIONBACKEND_H_
@@ -0,0 +1,249 @@
+// EvaluationHistory.cpp
+
+#include "EvaluationHistory.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace OPENSOLVER {
+
+// Once full, evict down to this fraction of the cap so that eviction, which
+// sorts the whole store, only runs every so often
+const double EVICTION_TARGET = 0.75;
+
+// Rows allocated when the first point is added
+const size_t INITIAL_ROWS = 64;
+
+EvaluationHistory::EvaluationHistory(int numVars, int numCons, int numObjs,
+                                     size_t memoryCap, bool floatOutputs) :
+    _n(numVars),
+    _m(numCons),
+    _numObjs(numObjs),
+    _memoryCap(memoryCap),
+    _floatOutputs(floatOutputs),
+    _xColumns(numVars),
+    _hasIncumbent(false),
+    _incumbentF(0),
+    _incumbentH(0),
+    _numAdded(0),
+    _numEvicted(0),
+    _peakMemory(0) {
+  if (_floatOutputs) {
+    _floatColumns.resize(numCons);
+  } else {
+    _doubleColumns.resize(numCons);
+  }
+}
+
+size_t EvaluationHistory::GetRowSize() const {
+  size_t outputSize = _floatOutputs ? sizeof(float) : sizeof(double);
+  return _n * sizeof(double) + _m * outputSize + 2 * sizeof(double);
+}
+
+size_t EvaluationHistory::GetMaxRows() const {
+  size_t fixedBytes = (_n + _m) * sizeof(double);  // The incumbent
+  size_t maxRows = (_memoryCap > fixedBytes)
+                   ? (_memoryCap - fixedBytes) / GetRowSize() : 0;
+  return std::max(maxRows, static_cast<size_t>(1));
+}
+
+void EvaluationHistory::Reserve(size_t numRows) {
+  for (int j = 0; j < _n; ++j) {
+    _xColumns[j].reserve(numRows);
+  }
+  for (int i = 0; i < _m; ++i) {
+    if (_floatOutputs) {
+      _floatColumns[i].reserve(numRows);
+    } else {
+      _doubleColumns[i].reserve(numRows);
+    }
+  }
+  _f.reserve(numRows);
+  _h.reserve(numRows);
+}
+
+size_t EvaluationHistory::GetMemoryUsed() const {
+  return _f.capacity() * GetRowSize() +
+         (_incumbentX.capacity() + _incumbentOutputs.capacity()) *
+         sizeof(double);
+}
+
+void EvaluationHistory::Add(const double* x, const double* outputs) {
+  ++_numAdded;
+
+  double f = (_numObjs > 0) ? outputs[0] : 0;
+  double h = 0;
+  for (int i = _numObjs; i < _m; ++i) {
+    if (outputs[i] > 0) {
+      h += outputs[i] * outputs[i];
+    }
+  }
+  bool failed = false;
+  for (int i = 0; i < _m; ++i) {
+    failed = failed || std::isnan(outputs[i]);
+  }
+  if (failed) {
+    f = std::numeric_limits<double>::infinity();
+    h = std::numeric_limits<double>::infinity();
+  }
+
+  // Grow the columns ourselves so they never outgrow the cap
+  size_t maxRows = GetMaxRows();
+  if (_f.size() >= maxRows) {
+    Evict();
+  }
+  if (_f.size() == _f.capacity()) {
+    Reserve(std::min(std::max(2 * _f.size(), INITIAL_ROWS), maxRows));
+  }
+
+  for (int j = 0; j < _n; ++j) {
+    _xColumns[j].push_back(x[j]);
+  }
+  for (int i = 0; i < _m; ++i) {
+    if (_floatOutputs) {
+      _floatColumns[i].push_back(static_cast<float>(outputs[i]));
+    } else {
+      _doubleColumns[i].push_back(outputs[i]);
+    }
+  }
+  _f.push_back(f);
+  _h.push_back(h);
+
+  if (!failed) {
+    bool better = !_hasIncumbent ||
+                  (h == 0 ? (_incumbentH > 0 || f < _incumbentF)
+                          : (_incumbentH > 0 && h < _incumbentH));
+    if (better) {
+      _hasIncumbent = true;
+      _incumbentF = f;
+      _incumbentH = h;
+      _incumbentX.assign(x, x + _n);
+      _incumbentOutputs.assign(outputs, outputs + _m);
+    }
+  }
+
+  _peakMemory = std::max(_peakMemory, GetMemoryUsed());
+}
+
+bool EvaluationHistory::GetIncumbent(std::vector<double>* x,
+                                     std::vector<double>* outputs) const {
+  if (!_hasIncumbent) {
+    return false;
+  }
+  *x = _incumbentX;
+  *outputs = _incumbentOutputs;
+  return true;
+}
+
+void EvaluationHistory::RemoveRow(size_t row) {
+  size_t last = _f.size() - 1;
+  for (int j = 0; j < _n; ++j) {
+    _xColumns[j][row] = _xColumns[j][last];
+    _xColumns[j].pop_back();
+  }
+  for (int i = 0; i < _m; ++i) {
+    if (_floatOutputs) {
+      _floatColumns[i][row] = _floatColumns[i][last];
+      _floatColumns[i].pop_back();
+    } else {
+      _doubleColumns[i][row] = _doubleColumns[i][last];
+      _doubleColumns[i].pop_back();
+    }
+  }
+  _f[row] = _f[last];
+  _f.pop_back();
+  _h[row] = _h[last];
+  _h.pop_back();
+  ++_numEvicted;
+}
+
+// Orders rows by violation, then objective
+struct ViolationOrder {
+  const std::vector<double>* f;
+  const std::vector<double>* h;
+  bool operator()(size_t a, size_t b) const {
+    if ((*h)[a] != (*h)[b]) {
+      return (*h)[a] < (*h)[b];
+    }
+    return (*f)[a] < (*f)[b];
+  }
+};
+
+std::vector<std::vector<double> > EvaluationHistory::GetBestPoints(
+    int maxPoints) const {
+  std::vector<size_t> order;
+  for (size_t row = 0; row < _f.size(); ++row) {
+    if (!std::isinf(_h[row])) {
+      order.push_back(row);
+    }
+  }
+  size_t numPoints = std::min(order.size(),
+                              static_cast<size_t>(std::max(maxPoints, 0)));
+  ViolationOrder byViolation = {&_f, &_h};
+  std::partial_sort(order.begin(), order.begin() + numPoints, order.end(),
+                    byViolation);
+
+  std::vector<std::vector<double> > points(numPoints,
+                                           std::vector<double>(_n));
+  for (size_t k = 0; k < numPoints; ++k) {
+    for (int j = 0; j < _n; ++j) {
+      points[k][j] = _xColumns[j][order[k]];
+    }
+  }
+  return points;
+}
+
+void EvaluationHistory::Evict() {
+  size_t numRows = _f.size();
+  size_t targetRows = static_cast<size_t>(EVICTION_TARGET * GetMaxRows());
+  if (numRows <= targetRows) {
+    return;
+  }
+
+  // Sweep in order of violation: a point is dominated if an earlier point
+  // (no more violated) already had an objective at least as good
+  std::vector<size_t> order(numRows);
+  for (size_t i = 0; i < numRows; ++i) {
+    order[i] = i;
+  }
+  ViolationOrder byViolation = {&_f, &_h};
+  std::sort(order.begin(), order.end(), byViolation);
+
+  std::vector<size_t> dominated;
+  std::vector<size_t> undominated;
+  double bestF = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < numRows; ++i) {
+    size_t row = order[i];
+    if (i > 0 && _f[row] >= bestF) {
+      dominated.push_back(row);
+    } else {
+      undominated.push_back(row);
+    }
+    bestF = std::min(bestF, _f[row]);
+  }
+
+  // Evict the worst dominated points first, then the worst of the rest, but
+  // never the least violated point
+  std::vector<bool> evict(numRows, false);
+  size_t numToEvict = numRows - targetRows;
+  size_t numMarked = 0;
+  for (size_t i = dominated.size(); i > 0 && numMarked < numToEvict; --i) {
+    evict[dominated[i - 1]] = true;
+    ++numMarked;
+  }
+  for (size_t i = undominated.size(); i > 1 && numMarked < numToEvict; --i) {
+    evict[undominated[i - 1]] = true;
+    ++numMarked;
+  }
+
+  // Remove from the back so that moved rows have already been checked
+  for (size_t row = numRows; row > 0; --row) {
+    if (evict[row - 1]) {
+      RemoveRow(row - 1);
+    }
+  }
+}
+
+}  // namespace OPENSOLVER
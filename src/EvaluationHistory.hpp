@@ -0,0 +1,110 @@
+// EvaluationHistory.hpp
+// Compact, bounded store of every evaluation made during a solve
+//
+// Points are kept column by column: one packed array per variable and per
+// output, plus the objective and constraint violation of each point. Outputs
+// other than those of the incumbent can be kept as floats to halve their
+// size. Once the store reaches its memory cap, points dominated in both
+// objective and violation by another point are evicted first.
+//
+// With the store in place NOMAD only needs the objectives and the largest
+// constraint value (see ConstraintAggregator), so its own cache no longer
+// grows with the number of outputs in the model.
+
+#ifndef SRC_EVALUATIONHISTORY_H_
+#define SRC_EVALUATIONHISTORY_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace OPENSOLVER {
+
+class EvaluationHistory {
+ public:
+  /**
+   * @param numVars The number of variables in the model
+   * @param numCons The number of outputs, including the objectives
+   * @param numObjs The number of objectives, which come first
+   * @param memoryCap The most bytes the store may use
+   * @param floatOutputs True to keep outputs of non-incumbents as floats
+   */
+  EvaluationHistory(int numVars, int numCons, int numObjs, size_t memoryCap,
+                    bool floatOutputs);
+
+  /**
+   * Adds an evaluation to the store, evicting points if it is full
+   *
+   * @param x The variable values of the point
+   * @param outputs The outputs of the point, NaN for Excel errors
+   */
+  void Add(const double* x, const double* outputs);
+
+  /**
+   * Gets the incumbent, in full precision
+   *
+   * The incumbent is the feasible point with the lowest first objective, or
+   * the point with the smallest violation if none is feasible.
+   * @param x Set to the variable values of the incumbent
+   * @param outputs Set to the outputs of the incumbent
+   * @return False if nothing has been evaluated successfully
+   */
+  bool GetIncumbent(std::vector<double>* x, std::vector<double>* outputs) const;
+
+  /**
+   * Gets the best points in the store, ranked by violation then objective
+   *
+   * @param maxPoints The most points to return
+   * @return The variable values of each point, best first, without points
+   *         that gave Excel errors
+   */
+  std::vector<std::vector<double> > GetBestPoints(int maxPoints) const;
+
+  int GetNumStored() const { return static_cast<int>(_f.size()); }
+  int GetNumAdded() const { return _numAdded; }
+  int GetNumEvicted() const { return _numEvicted; }
+  size_t GetMemoryUsed() const;
+  size_t GetPeakMemory() const { return _peakMemory; }
+
+ private:
+  // Removes points until the store is under its eviction target
+  void Evict();
+
+  // Removes a row by moving the last row into its place
+  void RemoveRow(size_t row);
+
+  size_t GetRowSize() const;
+
+  // Most rows that fit in the memory cap, at least one
+  size_t GetMaxRows() const;
+
+  // Reserves space for the given number of rows in every column
+  void Reserve(size_t numRows);
+
+  int                               _n;
+  int                               _m;
+  int                               _numObjs;
+  size_t                            _memoryCap;
+  bool                              _floatOutputs;
+
+  // One packed array per variable and per output, all the same length
+  std::vector<std::vector<double> > _xColumns;
+  std::vector<std::vector<float> >  _floatColumns;
+  std::vector<std::vector<double> > _doubleColumns;
+  std::vector<double>               _f;  // First objective, inf if failed
+  std::vector<double>               _h;  // Sum of squared violations
+
+  // The incumbent is also kept in full precision
+  bool                              _hasIncumbent;
+  double                            _incumbentF;
+  double                            _incumbentH;
+  std::vector<double>               _incumbentX;
+  std::vector<double>               _incumbentOutputs;
+
+  int                               _numAdded;
+  int                               _numEvicted;
+  size_t                            _peakMemory;
+};
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_EVALUATIONHISTORY_H_
@@ -0,0 +1,62 @@
+// EvaluationOrder.cpp
+
+#include "EvaluationOrder.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace OPENSOLVER {
+
+int CountChangedVariables(const double* x, const double* y, int n) {
+  int numChanged = 0;
+  for (int i = 0; i < n; ++i) {
+    if (x[i] != y[i]) {
+      ++numChanged;
+    }
+  }
+  return numChanged;
+}
+
+std::vector<int> OrderForLocality(const std::vector<const double*>& points,
+                                  int n, const double* start) {
+  const int numPoints = static_cast<int>(points.size());
+  std::vector<int> order;
+  order.reserve(numPoints);
+  std::vector<bool> visited(numPoints, false);
+  const double* current = start;
+  while (static_cast<int>(order.size()) < numPoints) {
+    int next = -1;
+    int nextChanged = 0;
+    for (int k = 0; k < numPoints; ++k) {
+      if (visited[k]) {
+        continue;
+      }
+      int changed = (current == nullptr)
+                    ? 0 : CountChangedVariables(current, points[k], n);
+      if (next < 0 || changed < nextChanged) {
+        next = k;
+        nextChanged = changed;
+      }
+    }
+    current = points[next];
+    visited[next] = true;
+    order.push_back(next);
+  }
+  return order;
+}
+
+int CountTourChanges(const std::vector<const double*>& points,
+                     const std::vector<int>& order, int n,
+                     const double* start) {
+  int numChanged = 0;
+  if (start != nullptr && !order.empty()) {
+    numChanged += CountChangedVariables(start, points[order[0]], n);
+  }
+  for (size_t k = 1; k < order.size(); ++k) {
+    numChanged += CountChangedVariables(points[order[k - 1]],
+                                        points[order[k]], n);
+  }
+  return numChanged;
+}
+
+}  // namespace OPENSOLVER
@@ -0,0 +1,52 @@
+// EvaluationOrder.hpp
+// Ordering of a block of trial points to reduce recalculation
+//
+// NOMAD hands over a block of poll or search points in its own order, in
+// which consecutive points can differ in many variables. Excel only
+// recalculates the cells that depend on changed variables, so visiting the
+// block along a short tour, each point followed by the one that changes the
+// fewest variables, makes the recalculations cheaper.
+
+#ifndef SRC_EVALUATIONORDER_H_
+#define SRC_EVALUATIONORDER_H_
+
+#include <vector>
+
+namespace OPENSOLVER {
+
+// Counts the variables that differ between two points
+int CountChangedVariables(const double* x, const double* y, int n);
+
+/**
+ * Orders points so that consecutive points differ in few variables
+ *
+ * Builds a nearest-neighbour tour by number of changed variables, with ties
+ * going to the point listed first. The tour starts from the variables
+ * already in the model, so the first point is the one that changes fewest
+ * of them. NOMAD lists its most promising candidate first, so that point
+ * starts the tour when nothing is known about the model's variables.
+ * @param points The variable values of each point
+ * @param n The number of variables
+ * @param start The variable values in the model, or nullptr if unknown
+ * @return The indices of the points in the order to evaluate them
+ */
+std::vector<int> OrderForLocality(const std::vector<const double*>& points,
+                                  int n, const double* start);
+
+/**
+ * Counts the variables changed when visiting points in the given order
+ *
+ * @param points The variable values of each point
+ * @param order The indices of the points in the order they are visited
+ * @param n The number of variables
+ * @param start The variable values in the model, or nullptr if unknown
+ * @return The total over each pair of consecutive points, including the
+ *         step from start to the first point
+ */
+int CountTourChanges(const std::vector<const double*>& points,
+                     const std::vector<int>& order, int n,
+                     const double* start);
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_EVALUATIONORDER_H_
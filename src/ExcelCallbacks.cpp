@@ -3,7 +3,9 @@
 
 #include "ExcelCallbacks.hpp"
 
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace OPENSOLVER {
 
@@ -78,6 +80,36 @@ std::string GetExcelCallbackErrorMessage(EXCEL_RC rc) {
     case GET_USE_WARMSTART:
       messageLocation = "GetUseWarmstart";
       break;
+    case OPEN_TRANSPORT_NUM:
+      messageLocation = "OpenTransport";
+      break;
+    case GET_PROBLEM_DESCRIPTOR_NUM:
+      messageLocation = "GetProblemDescriptor";
+      break;
+    case GET_PRECHECK_OUTPUTS_NUM:
+      messageLocation = "GetPrecheckOutputs";
+      break;
+    case RECALCULATE_PRECHECK_NUM:
+      messageLocation = "RecalculatePrecheck";
+      break;
+    case GET_PRECHECK_VALUES_NUM:
+      messageLocation = "GetPrecheckValues";
+      break;
+    case GET_HAS_SURROGATE_NUM:
+      messageLocation = "GetHasSurrogate";
+      break;
+    case RECALCULATE_SURROGATE_NUM:
+      messageLocation = "RecalculateSurrogate";
+      break;
+    case GET_NUM_SCENARIOS_NUM:
+      messageLocation = "GetNumScenarios";
+      break;
+    case APPLY_SCENARIO_NUM:
+      messageLocation = "ApplyScenario";
+      break;
+    case LOAD_SCENARIO_RESULTS_NUM:
+      messageLocation = "LoadScenarioResults";
+      break;
     default:
       messageLocation = "unknown";
       break;
@@ -92,6 +124,85 @@ void ValidateReturnCode(EXCEL_RC rc) {
   }
 }
 
+EXCEL_RC LoadProblem(ProblemDescriptor* problem, int* numHostCalls) {
+  *numHostCalls = 1;
+  if (GetProblemDescriptor(problem) == SUCCESS) {
+    return SUCCESS;
+  }
+
+  // Older hosts only have the individual calls
+  *problem = ProblemDescriptor();
+  EXCEL_RC rc;
+
+  ++*numHostCalls;
+  rc = GetLogFilePath(&problem->logPath);
+  if (rc != SUCCESS) {
+    problem->logPath.clear();
+    return rc;
+  }
+
+  ++*numHostCalls;
+  rc = GetNumVariables(&problem->numVars);
+  if (rc != SUCCESS) {
+    return rc;
+  }
+  if (problem->numVars < 1) {
+    // Nothing more to read, the caller reports the missing variables
+    return SUCCESS;
+  }
+
+  problem->lowerBounds.resize(problem->numVars);
+  problem->upperBounds.resize(problem->numVars);
+  problem->startingX.resize(problem->numVars);
+  problem->varTypes.resize(problem->numVars);
+  ++*numHostCalls;
+  rc = GetVariableData(problem->numVars, problem->lowerBounds.data(),
+                       problem->upperBounds.data(), problem->startingX.data(),
+                       problem->varTypes.data());
+  if (rc != SUCCESS) {
+    return rc;
+  }
+
+  ++*numHostCalls;
+  rc = GetNumConstraints(&problem->numCons, &problem->numObjs);
+  if (rc != SUCCESS) {
+    return rc;
+  }
+
+  std::string* paramStrings = nullptr;
+  int numStrings = 0;
+  ++*numHostCalls;
+  rc = GetOptionData(&paramStrings, &numStrings);
+  if (paramStrings != nullptr) {
+    if (rc == SUCCESS) {
+      problem->options.assign(paramStrings, paramStrings + numStrings);
+    }
+    delete[] paramStrings;
+  }
+  if (rc != SUCCESS) {
+    return rc;
+  }
+
+  ++*numHostCalls;
+  rc = GetUseWarmstart(&problem->useWarmstart);
+  if (rc != SUCCESS) {
+    return rc;
+  }
+
+  // Pre-checks are optional, so a host without them isn't an error
+  ++*numHostCalls;
+  if (GetPrecheckOutputs(&problem->precheckOutputs) != SUCCESS) {
+    problem->precheckOutputs.clear();
+  }
+
+  // As is a low-fidelity mode
+  ++*numHostCalls;
+  if (GetHasSurrogate(&problem->hasSurrogate) != SUCCESS) {
+    problem->hasSurrogate = false;
+  }
+  return SUCCESS;
+}
+
 EXCEL_RC EvaluateX(double* newVars, int numVars, int numCons,
                    const double* bestSolution, bool feasibility,
                    double* newCons) {
@@ -128,4 +239,104 @@ ErrorHandler:
   }
 }
 
+EXCEL_RC SurrogateEvaluateX(double* newVars, int numVars, int numCons,
+                            const double* bestSolution, bool feasibility,
+                            double* newCons) {
+  EXCEL_RC rc;
+
+  rc = CheckForEscapeKeypress(true);
+  if (rc != SUCCESS) {
+    goto ErrorHandler;
+  }
+
+  rc = UpdateVars(newVars, numVars, bestSolution, feasibility);
+  if (rc != SUCCESS) {
+    goto ErrorHandler;
+  }
+
+  rc = RecalculateSurrogate();
+  if (rc != SUCCESS) {
+    goto ErrorHandler;
+  }
+
+  rc = GetConstraintValues(numCons, newCons);
+  if (rc != SUCCESS) {
+    goto ErrorHandler;
+  }
+
+  return SUCCESS;
+
+ErrorHandler:
+  // Confirm whether the error is the result of an escape keypress
+  if (GetErrorCode(CheckForEscapeKeypress(false)) == ESC_ABORT) {
+    return ESC_ABORT;
+  } else {
+    return rc;
+  }
+}
+
+EXCEL_RC PrecheckX(double* newVars, int numVars, const double* bestSolution,
+                   bool feasibility, int numPrecheck, double* values) {
+  EXCEL_RC rc;
+
+  rc = CheckForEscapeKeypress(true);
+  if (rc != SUCCESS) {
+    goto ErrorHandler;
+  }
+
+  rc = UpdateVars(newVars, numVars, bestSolution, feasibility);
+  if (rc != SUCCESS) {
+    goto ErrorHandler;
+  }
+
+  rc = RecalculatePrecheck();
+  if (rc != SUCCESS) {
+    goto ErrorHandler;
+  }
+
+  rc = GetPrecheckValues(numPrecheck, values);
+  if (rc != SUCCESS) {
+    goto ErrorHandler;
+  }
+
+  return SUCCESS;
+
+ErrorHandler:
+  // Confirm whether the error is the result of an escape keypress
+  if (GetErrorCode(CheckForEscapeKeypress(false)) == ESC_ABORT) {
+    return ESC_ABORT;
+  } else {
+    return rc;
+  }
+}
+
+EXCEL_RC ReevaluateX(int numCons, double* newCons) {
+  EXCEL_RC rc;
+
+  rc = CheckForEscapeKeypress(true);
+  if (rc != SUCCESS) {
+    goto ErrorHandler;
+  }
+
+  rc = RecalculateValues();
+  if (rc != SUCCESS) {
+    goto ErrorHandler;
+  }
+
+  rc = GetConstraintValues(numCons, newCons);
+  if (rc != SUCCESS) {
+    goto ErrorHandler;
+  }
+
+  return SUCCESS;
+
+ErrorHandler:
+  // Confirm whether the error is the result of an escape keypress
+  if (GetErrorCode(CheckForEscapeKeypress(false)) == ESC_ABORT) {
+    return ESC_ABORT;
+  } else {
+    return rc;
+  }
+}
+
 }  // namespace OPENSOLVER
@@ -8,6 +8,7 @@
 #define SRC_EXCELCALLBACKS_H_
 
 #include <string>
+#include <vector>
 
 namespace OPENSOLVER {
 
@@ -23,6 +24,21 @@ const char GET_CONFIRMED_ABORT_NAME[] = "OpenSolver.NOMAD_GetConfirmedAbort";
 const char UPDATE_VAR_NAME[] =          "OpenSolver.NOMAD_UpdateVar";
 const char RECALCULATE_VALUES_NAME[] =  "OpenSolver.NOMAD_RecalculateValues";
 const char GET_VALUES_NAME[] =          "OpenSolver.NOMAD_GetValues";
+const char OPEN_TRANSPORT_NAME[] =      "OpenSolver.NOMAD_OpenTransport";
+const char GET_PROBLEM_DESCRIPTOR_NAME[] =
+    "OpenSolver.NOMAD_GetProblemDescriptor";
+const char GET_PRECHECK_OUTPUTS_NAME[] =
+    "OpenSolver.NOMAD_GetPrecheckOutputs";
+const char RECALCULATE_PRECHECK_NAME[] =
+    "OpenSolver.NOMAD_RecalculatePrecheck";
+const char GET_PRECHECK_VALUES_NAME[] = "OpenSolver.NOMAD_GetPrecheckValues";
+const char GET_HAS_SURROGATE_NAME[] =   "OpenSolver.NOMAD_GetHasSurrogate";
+const char RECALCULATE_SURROGATE_NAME[] =
+    "OpenSolver.NOMAD_RecalculateSurrogate";
+const char GET_NUM_SCENARIOS_NAME[] =   "OpenSolver.NOMAD_GetNumScenarios";
+const char APPLY_SCENARIO_NAME[] =      "OpenSolver.NOMAD_ApplyScenario";
+const char LOAD_SCENARIO_RESULTS_NAME[] =
+    "OpenSolver.NOMAD_LoadScenarioResults";
 
 // Error codes
 enum {
@@ -47,6 +63,32 @@ enum {
   RECALCULATE_VALUES_NUM = 9,
   GET_CONSTRAINT_VALUES_NUM = 10,
   GET_USE_WARMSTART = 11,
+  OPEN_TRANSPORT_NUM = 12,
+  GET_PROBLEM_DESCRIPTOR_NUM = 13,
+  GET_PRECHECK_OUTPUTS_NUM = 14,
+  RECALCULATE_PRECHECK_NUM = 15,
+  GET_PRECHECK_VALUES_NUM = 16,
+  GET_HAS_SURROGATE_NUM = 17,
+  RECALCULATE_SURROGATE_NUM = 18,
+  GET_NUM_SCENARIOS_NUM = 19,
+  APPLY_SCENARIO_NUM = 20,
+  LOAD_SCENARIO_RESULTS_NUM = 21,
+};
+
+// Everything about the problem that is read from Excel before solving
+struct ProblemDescriptor {
+  std::string               logPath;
+  int                       numVars;
+  std::vector<double>       lowerBounds;
+  std::vector<double>       upperBounds;
+  std::vector<double>       startingX;
+  std::vector<int>          varTypes;    // See VarType
+  int                       numCons;     // Including the objectives
+  int                       numObjs;
+  std::vector<std::string>  options;     // NOMAD parameter strings
+  bool                      useWarmstart;
+  std::vector<int>          precheckOutputs;  // See GetPrecheckOutputs
+  bool                      hasSurrogate;     // See GetHasSurrogate
 };
 
 // Define type for Excel return code
@@ -144,6 +186,96 @@ EXCEL_RC GetOptionData(std::string **paramStrings, int* numOptions);
  */
 EXCEL_RC GetUseWarmstart(bool* useWarmstart);
 
+/**
+ * Gets the constraints that Excel can calculate on their own
+ *
+ * These are cheap checks, such as budget sums, that can reject a point before
+ * the rest of the model is calculated. Hosts without pre-checks fail or
+ * return none.
+ * @param outputs Set to the indices of the pre-check outputs, counting from 0
+ *                in the order of GetConstraintValues
+ * @return The return code of the callback
+ */
+EXCEL_RC GetPrecheckOutputs(std::vector<int>* outputs);
+
+/**
+ * Calculates only the pre-check outputs in Excel
+ *
+ * @return The return code of the callback
+ */
+EXCEL_RC RecalculatePrecheck();
+
+/**
+ * Gets the values of the pre-check outputs from Excel
+ *
+ * @param numPrecheck The number of pre-check outputs
+ * @param values Array to store the value of each pre-check output
+ * @return The return code of the callback
+ */
+EXCEL_RC GetPrecheckValues(int numPrecheck, double* values);
+
+/**
+ * Gets whether the model has a low-fidelity mode from Excel
+ *
+ * Some workbooks can compute an approximate answer much faster than the full
+ * one. Hosts without a low-fidelity mode fail or return false.
+ * @param hasSurrogate Set to true if RecalculateSurrogate can be used
+ * @return The return code of the callback
+ */
+EXCEL_RC GetHasSurrogate(bool* hasSurrogate);
+
+/**
+ * Recalculates Excel in its low-fidelity mode
+ *
+ * The approximate values are then read with GetConstraintValues. The next
+ * RecalculateValues gives the full values again.
+ * @return The return code of the callback
+ */
+EXCEL_RC RecalculateSurrogate();
+
+/**
+ * Gets the number of scenarios to solve in a batch from Excel
+ *
+ * @param numScenarios Set to the number of scenarios
+ * @return The return code of the callback
+ */
+EXCEL_RC GetNumScenarios(int* numScenarios);
+
+/**
+ * Makes a scenario of the batch current in Excel
+ *
+ * Excel sets the scenario's input cells, and the bounds and options that the
+ * next LoadProblem reads.
+ * @param scenario The index of the scenario, counting from 0
+ * @param parameters Set to the values that define the scenario, such as its
+ *                   input cells, used to find similar scenarios
+ * @return The return code of the callback
+ */
+EXCEL_RC ApplyScenario(int scenario, std::vector<double>* parameters);
+
+/**
+ * Loads the results of a batch into Excel as a single table
+ *
+ * @param numRows The number of rows, one per scenario
+ * @param numColumns The number of columns
+ * @param table The values of the table row by row, NaN for blank cells
+ * @return The return code of the callback
+ */
+EXCEL_RC LoadScenarioResults(int numRows, int numColumns, const double* table);
+
+/**
+ * Gets the whole problem from Excel in a single call
+ *
+ * This returns the same information as GetLogFilePath, GetNumVariables,
+ * GetVariableData, GetNumConstraints, GetOptionData, GetUseWarmstart,
+ * GetPrecheckOutputs and GetHasSurrogate.
+ * It fails if the host doesn't support it, in which case those calls are
+ * used instead (see LoadProblem).
+ * @param problem Set to the problem
+ * @return The return code of the callback
+ */
+EXCEL_RC GetProblemDescriptor(ProblemDescriptor* problem);
+
 /**
  * Sets new values of variables in Excel
  *
@@ -172,6 +304,18 @@ EXCEL_RC RecalculateValues();
  */
 EXCEL_RC GetConstraintValues(int numCons, double* newCons);
 
+/**
+ * Gets the whole problem from Excel
+ *
+ * Uses GetProblemDescriptor if the host supports it, and otherwise falls
+ * back to the individual calls. The log path is read first, so if it is
+ * empty on failure then the log file can't be written.
+ * @param problem Set to the problem
+ * @param numHostCalls Set to the number of calls made to the host
+ * @return The return code of the callback
+ */
+EXCEL_RC LoadProblem(ProblemDescriptor* problem, int* numHostCalls);
+
 /**
  * Conduct an evaluation iteration in Excel
  *
@@ -189,6 +333,49 @@ EXCEL_RC EvaluateX(double* newVars, int numVars, int numCons,
                    const double* bestSolution, bool feasibility,
                    double* newCons);
 
+/**
+ * Conduct a low-fidelity evaluation in Excel
+ *
+ * The same as EvaluateX, but recalculates with RecalculateSurrogate.
+ * @param newValues Array of new variable values to set
+ * @param numVars The number of variables in the model
+ * @param numCons The number of constraints in the model
+ * @param bestSolution Pointer to current best solution (NULL if no solution)
+ * @param feasibility True if current best solution is feasible
+ * @param newCons Array to store the approximate value of each constraint cell
+ * @return The return code of the callback
+ */
+EXCEL_RC SurrogateEvaluateX(double* newVars, int numVars, int numCons,
+                            const double* bestSolution, bool feasibility,
+                            double* newCons);
+
+/**
+ * Conduct a pre-check evaluation in Excel
+ *
+ * Sets the values of variables in Excel, calculates only the pre-check
+ * outputs, and reads them out. ReevaluateX then completes the evaluation.
+ * @param newValues Array of new variable values to set
+ * @param numVars The number of variables in the model
+ * @param bestSolution Pointer to current best solution (NULL if no solution)
+ * @param feasibility True if current best solution is feasible
+ * @param numPrecheck The number of pre-check outputs
+ * @param values Array to store the value of each pre-check output
+ * @return The return code of the callback
+ */
+EXCEL_RC PrecheckX(double* newVars, int numVars, const double* bestSolution,
+                   bool feasibility, int numPrecheck, double* values);
+
+/**
+ * Conduct a repeat evaluation in Excel of the variables last set
+ *
+ * Recalculates and reads out the constraint cells again without updating the
+ * variables, which gives a fresh sample for models that use RAND().
+ * @param numCons The number of constraints in the model
+ * @param newCons Array to store the new values of each constraint cell
+ * @return The return code of the callback
+ */
+EXCEL_RC ReevaluateX(int numCons, double* newCons);
+
 #ifdef __APPLE__
 /**
  * Load the NOMAD result into Excel (OS X-only)
@@ -6,7 +6,14 @@
 #import <Carbon/Carbon.h>
 #import <Foundation/Foundation.h>
 
+#include <unistd.h>
+
+#include <cmath>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include "SharedMemoryTransport.hpp"
 
 namespace OPENSOLVER {
 
@@ -121,9 +128,60 @@ EXCEL_RC ConvertDescriptorToString(NSAppleEventDescriptor* result, std::string*
   return SUCCESS;
 }
 
+// Asks the host to attach to the shared-memory transport with the given name
+EXCEL_RC OpenTransport(const std::string& name) {
+  @autoreleasepool {
+    NSAppleEventDescriptor *params = [NSAppleEventDescriptor listDescriptor];
+    [params insertDescriptor:[NSAppleEventDescriptor descriptorWithString:@(name.c_str())]
+                     atIndex:1];
+    NSAppleEventDescriptor* result = RunScriptFunction(@"openTransport", params);
+    EXCEL_RC rc = CheckReturn(result);
+    if (rc == SUCCESS) {
+      int retval;
+      rc = ConvertDescriptorToInt(result, &retval);
+      if (rc != SUCCESS || retval != 0) {
+        rc = EXCEL_INVALID_RETURN;
+      }
+    }
+    return AddLocationIfError(rc, OPEN_TRANSPORT_NUM);
+  }
+}
+
+std::unique_ptr<SharedMemoryTransport> sharedTransport;
+bool triedSharedTransport = false;
+
+// Gets the shared-memory transport to the host, or nullptr if the host doesn't
+// support it. Apple Events are then only used to bootstrap the transport and
+// for the calls made outside of evaluations.
+Transport* GetTransport() {
+  if (!triedSharedTransport) {
+    triedSharedTransport = true;
+    std::string name = "/OpenSolverNomad." + std::to_string(getpid());
+    sharedTransport.reset(SharedMemoryTransport::Create(name));
+    // Fall back to Apple Events if the host doesn't attach
+    if (sharedTransport && (OpenTransport(name) != SUCCESS ||
+                            !sharedTransport->WaitForHost(HOST_ATTACH_TIMEOUT_S))) {
+      sharedTransport.reset();
+    }
+  }
+  return sharedTransport.get();
+}
+
+// Stops the host serving the transport, so that it takes Apple Events again.
+// The next call to GetTransport sets up a new one.
+void CloseTransport() {
+  sharedTransport.reset();
+  triedSharedTransport = false;
+}
+
 extern "C" {
 
 EXCEL_RC CheckForEscapeKeypress(bool /* fullCheck */) {
+  Transport* transport = GetTransport();
+  if (transport != nullptr) {
+    return TransportCheckForEscapeKeypress(transport);
+  }
+
   @autoreleasepool {
     NSAppleEventDescriptor *result = RunScriptFunction(@"getConfirmedAbort", nil);
     EXCEL_RC rc = CheckReturn(result);
@@ -257,8 +315,149 @@ EXCEL_RC GetUseWarmstart(bool* useWarmstart) {
   }
 }
 
+EXCEL_RC GetProblemDescriptor(ProblemDescriptor* problem) {
+  @autoreleasepool {
+    // The result is a list of: the log path string and its length, a list of
+    // the number of variables, constraints and objectives, the warmstart flag,
+    // the variable data as in getVariableData, a list of the option strings
+    // each with its length, the list of pre-check outputs, and whether there
+    // is a low-fidelity mode.
+    NSAppleEventDescriptor* result = RunScriptFunction(@"getProblemDescriptor", nil);
+    EXCEL_RC rc = CheckReturn(result);
+    if (rc == SUCCESS && !CheckListDescriptor(result, 7)) {
+      rc = EXCEL_INVALID_RETURN;
+    }
+    if (rc != SUCCESS) goto ExitFunction;
+
+    {
+      rc = ConvertDescriptorToString(GetVectorEntry(result, 1), &problem->logPath);
+      if (rc != SUCCESS) goto ExitFunction;
+
+      NSAppleEventDescriptor* sizes = GetVectorEntry(result, 2);
+      if (!CheckListDescriptor(sizes, 3)) {
+        rc = EXCEL_INVALID_RETURN;
+        goto ExitFunction;
+      }
+      rc = ConvertDescriptorToInt(GetVectorEntry(sizes, 1), &problem->numVars);
+      if (rc != SUCCESS) goto ExitFunction;
+      rc = ConvertDescriptorToInt(GetVectorEntry(sizes, 2), &problem->numCons);
+      if (rc != SUCCESS) goto ExitFunction;
+      rc = ConvertDescriptorToInt(GetVectorEntry(sizes, 3), &problem->numObjs);
+      if (rc != SUCCESS) goto ExitFunction;
+
+      NSAppleEventDescriptor* warmstart = GetVectorEntry(result, 3);
+      if (!CheckBoolDescriptor(warmstart)) {
+        rc = EXCEL_INVALID_RETURN;
+        goto ExitFunction;
+      }
+      problem->useWarmstart = ConvertDescriptorToBool(warmstart);
+
+      const int numVars = problem->numVars;
+      NSAppleEventDescriptor* varData = GetVectorEntry(result, 4);
+      if (numVars < 0 || !CheckListDescriptor(varData, 4 * numVars)) {
+        rc = EXCEL_INVALID_RETURN;
+        goto ExitFunction;
+      }
+      problem->lowerBounds.resize(numVars);
+      problem->upperBounds.resize(numVars);
+      problem->startingX.resize(numVars);
+      problem->varTypes.resize(numVars);
+      for (int i = 0; i < numVars; ++i) {
+        rc = ConvertDescriptorToDouble(GetVectorEntry(varData, 0 * numVars + i + 1),
+                                       &problem->lowerBounds[i]);
+        if (rc != SUCCESS) goto ExitFunction;
+
+        rc = ConvertDescriptorToDouble(GetVectorEntry(varData, 1 * numVars + i + 1),
+                                       &problem->upperBounds[i]);
+        if (rc != SUCCESS) goto ExitFunction;
+
+        rc = ConvertDescriptorToDouble(GetVectorEntry(varData, 2 * numVars + i + 1),
+                                       &problem->startingX[i]);
+        if (rc != SUCCESS) goto ExitFunction;
+
+        rc = ConvertDescriptorToInt(GetVectorEntry(varData, 3 * numVars + i + 1),
+                                    &problem->varTypes[i]);
+        if (rc != SUCCESS) goto ExitFunction;
+      }
+
+      NSAppleEventDescriptor* optionData = GetVectorEntry(result, 5);
+      if (optionData.descriptorType != 'list') {
+        rc = EXCEL_INVALID_RETURN;
+        goto ExitFunction;
+      }
+      problem->options.resize(optionData.numberOfItems);
+      for (size_t i = 0; i < problem->options.size(); ++i) {
+        rc = ConvertDescriptorToString(GetVectorEntry(optionData, i + 1), &problem->options[i]);
+        if (rc != SUCCESS) goto ExitFunction;
+      }
+
+      NSAppleEventDescriptor* precheckData = GetVectorEntry(result, 6);
+      if (precheckData.descriptorType != 'list') {
+        rc = EXCEL_INVALID_RETURN;
+        goto ExitFunction;
+      }
+      problem->precheckOutputs.resize(precheckData.numberOfItems);
+      for (size_t i = 0; i < problem->precheckOutputs.size(); ++i) {
+        rc = ConvertDescriptorToInt(GetVectorEntry(precheckData, i + 1),
+                                    &problem->precheckOutputs[i]);
+        if (rc != SUCCESS) goto ExitFunction;
+      }
+
+      NSAppleEventDescriptor* hasSurrogate = GetVectorEntry(result, 7);
+      if (!CheckBoolDescriptor(hasSurrogate)) {
+        rc = EXCEL_INVALID_RETURN;
+        goto ExitFunction;
+      }
+      problem->hasSurrogate = ConvertDescriptorToBool(hasSurrogate);
+    }
+
+ExitFunction:
+    return AddLocationIfError(rc, GET_PROBLEM_DESCRIPTOR_NUM);
+  }
+}
+
+EXCEL_RC GetPrecheckOutputs(std::vector<int>* outputs) {
+  @autoreleasepool {
+    NSAppleEventDescriptor* result = RunScriptFunction(@"getPrecheckOutputs", nil);
+    EXCEL_RC rc = CheckReturn(result);
+    outputs->clear();
+    if (rc == SUCCESS) {
+      if (result.descriptorType == 'list') {
+        outputs->resize(result.numberOfItems);
+        for (size_t i = 0; i < outputs->size(); ++i) {
+          rc = ConvertDescriptorToInt(GetVectorEntry(result, i + 1), &(*outputs)[i]);
+          if (rc != SUCCESS) break;
+        }
+      } else {
+        rc = EXCEL_INVALID_RETURN;
+      }
+    }
+    return AddLocationIfError(rc, GET_PRECHECK_OUTPUTS_NUM);
+  }
+}
+
+EXCEL_RC GetHasSurrogate(bool* hasSurrogate) {
+  @autoreleasepool {
+    NSAppleEventDescriptor* result = RunScriptFunction(@"getHasSurrogate", nil);
+    EXCEL_RC rc = CheckReturn(result);
+    if (rc == SUCCESS) {
+      if (CheckBoolDescriptor(result)) {
+        *hasSurrogate = ConvertDescriptorToBool(result);
+      } else {
+        rc = EXCEL_INVALID_RETURN;
+      }
+    }
+    return AddLocationIfError(rc, GET_HAS_SURROGATE_NUM);
+  }
+}
+
 EXCEL_RC UpdateVars(double* newVars, int numVars, const double* bestSolution,
                 bool feasibility) {
+  Transport* transport = GetTransport();
+  if (transport != nullptr) {
+    return TransportUpdateVars(transport, newVars, numVars, bestSolution, feasibility);
+  }
+
   @autoreleasepool {
 
     // Build array of new variables
@@ -302,6 +501,11 @@ EXCEL_RC UpdateVars(double* newVars, int numVars, const double* bestSolution,
 }
 
 EXCEL_RC RecalculateValues() {
+  Transport* transport = GetTransport();
+  if (transport != nullptr) {
+    return TransportRecalculateValues(transport);
+  }
+
   @autoreleasepool {
     NSAppleEventDescriptor* result = RunScriptFunction(@"recalculateValues", nil);
     EXCEL_RC rc = CheckReturn(result);
@@ -317,6 +521,11 @@ EXCEL_RC RecalculateValues() {
 }
 
 EXCEL_RC GetConstraintValues(int numCons, double* newCons) {
+  Transport* transport = GetTransport();
+  if (transport != nullptr) {
+    return TransportGetConstraintValues(transport, numCons, newCons);
+  }
+
   @autoreleasepool {
     NSAppleEventDescriptor* result = RunScriptFunction(@"getConstraintValues", nil);
     EXCEL_RC rc = CheckReturn(result);
@@ -341,7 +550,153 @@ EXCEL_RC GetConstraintValues(int numCons, double* newCons) {
   }
 }
 
+EXCEL_RC RecalculateSurrogate() {
+  Transport* transport = GetTransport();
+  if (transport != nullptr) {
+    return TransportRecalculateSurrogate(transport);
+  }
+
+  @autoreleasepool {
+    NSAppleEventDescriptor* result = RunScriptFunction(@"recalculateSurrogate", nil);
+    EXCEL_RC rc = CheckReturn(result);
+    if (rc == SUCCESS) {
+      int retval;
+      rc = ConvertDescriptorToInt(result, &retval);
+      if (rc != SUCCESS || retval != 0) {
+        rc = EXCEL_INVALID_RETURN;
+      }
+    }
+    return AddLocationIfError(rc, RECALCULATE_SURROGATE_NUM);
+  }
+}
+
+EXCEL_RC RecalculatePrecheck() {
+  Transport* transport = GetTransport();
+  if (transport != nullptr) {
+    return TransportRecalculatePrecheck(transport);
+  }
+
+  @autoreleasepool {
+    NSAppleEventDescriptor* result = RunScriptFunction(@"recalculatePrecheck", nil);
+    EXCEL_RC rc = CheckReturn(result);
+    if (rc == SUCCESS) {
+      int retval;
+      rc = ConvertDescriptorToInt(result, &retval);
+      if (rc != SUCCESS || retval != 0) {
+        rc = EXCEL_INVALID_RETURN;
+      }
+    }
+    return AddLocationIfError(rc, RECALCULATE_PRECHECK_NUM);
+  }
+}
+
+EXCEL_RC GetPrecheckValues(int numPrecheck, double* values) {
+  Transport* transport = GetTransport();
+  if (transport != nullptr) {
+    return TransportGetPrecheckValues(transport, numPrecheck, values);
+  }
+
+  @autoreleasepool {
+    NSAppleEventDescriptor* result = RunScriptFunction(@"getPrecheckValues", nil);
+    EXCEL_RC rc = CheckReturn(result);
+    if (rc == SUCCESS) {
+      if (CheckListDescriptor(result, numPrecheck)) {
+        for (int i = 0; i < numPrecheck; ++i) {
+          rc = ConvertDescriptorToDouble(GetMatrixEntry(result, i + 1, 1), values + i);
+          if (rc != SUCCESS) break;
+        }
+      } else if (result.descriptorType == 'list') {
+        // Some of the values are errors, as in GetConstraintValues
+        for (int i = 0; i < numPrecheck; ++i) {
+          values[i] = std::numeric_limits<double>::quiet_NaN();
+        }
+      } else {
+        rc = EXCEL_INVALID_RETURN;
+      }
+    }
+    return AddLocationIfError(rc, GET_PRECHECK_VALUES_NUM);
+  }
+}
+
+EXCEL_RC GetNumScenarios(int* numScenarios) {
+  CloseTransport();
+  @autoreleasepool {
+    NSAppleEventDescriptor* result = RunScriptFunction(@"getNumScenarios", nil);
+    EXCEL_RC rc = CheckReturn(result);
+    if (rc == SUCCESS) {
+      rc = ConvertDescriptorToInt(result, numScenarios);
+    }
+    return AddLocationIfError(rc, GET_NUM_SCENARIOS_NUM);
+  }
+}
+
+EXCEL_RC ApplyScenario(int scenario, std::vector<double>* parameters) {
+  // The previous scenario's solve leaves the host serving the transport
+  CloseTransport();
+  @autoreleasepool {
+    NSAppleEventDescriptor *params = [NSAppleEventDescriptor listDescriptor];
+    [params insertDescriptor:[NSAppleEventDescriptor descriptorWithInt32:scenario] atIndex:1];
+    NSAppleEventDescriptor* result = RunScriptFunction(@"applyScenario", params);
+    EXCEL_RC rc = CheckReturn(result);
+    parameters->clear();
+    if (rc == SUCCESS) {
+      if (result.descriptorType == 'list') {
+        parameters->resize(result.numberOfItems);
+        for (size_t i = 0; i < parameters->size(); ++i) {
+          rc = ConvertDescriptorToDouble(GetVectorEntry(result, i + 1), &(*parameters)[i]);
+          if (rc != SUCCESS) break;
+        }
+      } else {
+        int retval;
+        rc = ConvertDescriptorToInt(result, &retval);
+        if (rc != SUCCESS || retval != 0) {
+          rc = EXCEL_INVALID_RETURN;
+        }
+      }
+    }
+    return AddLocationIfError(rc, APPLY_SCENARIO_NUM);
+  }
+}
+
+EXCEL_RC LoadScenarioResults(int numRows, int numColumns, const double* table) {
+  CloseTransport();
+  @autoreleasepool {
+    // Build the table as a list of rows, with NaN as a blank entry
+    NSAppleEventDescriptor *rows = [NSAppleEventDescriptor listDescriptor];
+    for (int r = 0; r < numRows; ++r) {
+      NSAppleEventDescriptor *row = [NSAppleEventDescriptor listDescriptor];
+      for (int c = 0; c < numColumns; ++c) {
+        const double* value = table + r * numColumns + c;
+        NSAppleEventDescriptor *entry = std::isnan(*value)
+            ? [NSAppleEventDescriptor descriptorWithString:@""]
+            : [NSAppleEventDescriptor descriptorWithDescriptorType:'doub'
+                                                             bytes:value
+                                                            length:sizeof(double)];
+        [row insertDescriptor:entry atIndex:c + 1];
+      }
+      [rows insertDescriptor:row atIndex:r + 1];
+    }
+
+    NSAppleEventDescriptor *params = [NSAppleEventDescriptor listDescriptor];
+    [params insertDescriptor:rows atIndex:1];
+    NSAppleEventDescriptor* result = RunScriptFunction(@"loadScenarioResults", params);
+    EXCEL_RC rc = CheckReturn(result);
+    if (rc == SUCCESS) {
+      int retval;
+      rc = ConvertDescriptorToInt(result, &retval);
+      if (rc != SUCCESS || retval != 0) {
+        rc = EXCEL_INVALID_RETURN;
+      }
+    }
+    return AddLocationIfError(rc, LOAD_SCENARIO_RESULTS_NUM);
+  }
+}
+
 void LoadResult(int retVal) {
+  // Stop the host serving the transport before handing back control. A
+  // daemon sets up a new one for its next solve.
+  CloseTransport();
+
   @autoreleasepool {
     NSAppleEventDescriptor *params = [NSAppleEventDescriptor listDescriptor];
     [params insertDescriptor:[NSAppleEventDescriptor descriptorWithInt32:retVal] atIndex:1];
@@ -0,0 +1,541 @@
+// ExcelCallbacks.standin.cpp
+// Implementation of ExcelCallbacks.hpp for the in-process stand-in host
+
+#include "ExcelCallbacks.hpp"
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SharedMemoryTransport.hpp"
+#include "StandInHost.hpp"
+#include "Transport.hpp"
+
+namespace OPENSOLVER {
+
+// Cost of a low-fidelity recalculation relative to a full one
+const double STAND_IN_SURROGATE_COST = 0.02;
+
+const StandInProblem*  standInProblem = nullptr;
+std::vector<std::string> standInOptions;
+std::string            standInLogPath;
+bool                   standInWarmstart = true;
+double                 standInLatency = 0;
+double                 standInChangeLatency = 0;
+std::chrono::steady_clock::time_point standInStart;
+
+// Host state for the single-threaded callbacks, which like Excel's may only
+// be called from the thread that loaded the problem
+std::thread::id        standInHostThread;
+std::vector<double>    standInVars;
+std::vector<double>    standInCells;  // Variables at the last recalculation
+std::vector<double>    standInValues;
+std::vector<double>    standInPrecheckValues;
+
+// Scenarios of a batch, and the table of its results
+const std::vector<StandInScenario>* standInScenarios = nullptr;
+std::vector<std::vector<double> > standInScenarioResults;
+
+// Trace of all evaluations, shared with worker backends
+std::mutex             standInTraceMutex;
+std::vector<StandInEvaluation> standInTrace;
+
+// Transport to the host process, if the host runs in one
+std::unique_ptr<SharedMemoryTransport> standInTransport;
+pid_t                  standInHostPid = 0;
+
+void StartStandInSolve(const StandInProblem* problem,
+                       const std::vector<std::string>& options,
+                       const std::string& logPath, bool useWarmstart,
+                       double latency, double changeLatency) {
+  standInProblem = problem;
+  standInOptions = options;
+  standInLogPath = logPath;
+  standInWarmstart = useWarmstart;
+  standInLatency = latency;
+  standInChangeLatency = changeLatency;
+  standInVars = problem->startingX;
+  standInCells = problem->startingX;
+  standInValues.assign(problem->numCons, 0.0);
+
+  std::lock_guard<std::mutex> lock(standInTraceMutex);
+  standInTrace.clear();
+  standInStart = std::chrono::steady_clock::now();
+}
+
+void StartStandInBatch(const std::vector<StandInScenario>* scenarios,
+                       const std::vector<std::string>& options,
+                       const std::string& logPath, bool useWarmstart,
+                       double latency, double changeLatency) {
+  StartStandInSolve((*scenarios)[0].problem, options, logPath, useWarmstart,
+                    latency, changeLatency);
+  standInScenarios = scenarios;
+  standInScenarioResults.clear();
+}
+
+std::vector<std::vector<double> > GetStandInScenarioResults() {
+  return standInScenarioResults;
+}
+
+std::vector<StandInEvaluation> GetStandInTrace() {
+  std::lock_guard<std::mutex> lock(standInTraceMutex);
+  return standInTrace;
+}
+
+std::vector<double> GetStandInVars() {
+  return standInVars;
+}
+
+// Brings the cells up to date with the variables, returning how many of
+// them changed since the last recalculation
+int UpdateStandInCells(std::vector<double>* cells, const double* x) {
+  int numChanged = 0;
+  for (size_t i = 0; i < cells->size(); ++i) {
+    if ((*cells)[i] != x[i]) {
+      (*cells)[i] = x[i];
+      ++numChanged;
+    }
+  }
+  return numChanged;
+}
+
+// Waits as long as a recalculation with the given relative cost would take,
+// which like Excel's grows with the number of changed variables
+void WaitForStandInLatency(double cost, int numChanged) {
+  double seconds = (standInLatency + standInChangeLatency * numChanged) * cost;
+  if (seconds > 0) {
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  }
+}
+
+// Adds the outputs of a full evaluation to the trace
+void TraceStandIn(const double* values) {
+  StandInEvaluation evaluation;
+  evaluation.objective = standInProblem->numObjs > 0 ? values[0] : 0;
+  evaluation.feasible = !std::isnan(evaluation.objective);
+  for (int i = standInProblem->numObjs; i < standInProblem->numCons; ++i) {
+    if (!(values[i] <= 0)) {
+      evaluation.feasible = false;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(standInTraceMutex);
+  evaluation.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - standInStart).count();
+  standInTrace.push_back(evaluation);
+}
+
+// Evaluates the problem as a recalculation of the given cells would, and
+// traces the result
+void EvaluateStandIn(std::vector<double>* cells, const double* x,
+                     double* values) {
+  WaitForStandInLatency(1, UpdateStandInCells(cells, x));
+  standInProblem->evaluate(x, values);
+  TraceStandIn(values);
+}
+
+// Serves the host side of the transport in the host process
+class StandInTransportHandler : public TransportHandler {
+ public:
+  StandInTransportHandler() :
+      _vars(standInVars),
+      _cells(standInCells),
+      _values(standInProblem->numCons),
+      _precheckValues(standInProblem->precheckOutputs.size()) {}
+
+  EXCEL_RC Handle(int op, std::vector<double>* values) override {
+    const StandInProblem& problem = *standInProblem;
+    switch (op) {
+      case OP_CHECK_ABORT:
+        values->assign(1, 0.0);
+        return SUCCESS;
+      case OP_UPDATE_VARS:
+        // The status fields after the variables aren't shown anywhere
+        if (values->size() != static_cast<size_t>(problem.numVars) + 3) {
+          return EXCEL_INVALID_RETURN;
+        }
+        _vars.assign(values->begin(), values->begin() + problem.numVars);
+        values->clear();
+        return SUCCESS;
+      case OP_RECALCULATE_VALUES:
+        WaitForStandInLatency(1, UpdateStandInCells(&_cells, _vars.data()));
+        problem.evaluate(_vars.data(), _values.data());
+        values->clear();
+        return SUCCESS;
+      case OP_RECALCULATE_SURROGATE:
+        if (problem.surrogate == nullptr) {
+          return EXCEL_VBA_ERROR;
+        }
+        WaitForStandInLatency(STAND_IN_SURROGATE_COST,
+                              UpdateStandInCells(&_cells, _vars.data()));
+        problem.surrogate(_vars.data(), _values.data());
+        values->clear();
+        return SUCCESS;
+      case OP_GET_CONSTRAINT_VALUES:
+        *values = _values;
+        return SUCCESS;
+      case OP_RECALCULATE_PRECHECK: {
+        std::vector<double> outputs(problem.numCons);
+        problem.evaluate(_vars.data(), outputs.data());
+        for (size_t i = 0; i < _precheckValues.size(); ++i) {
+          _precheckValues[i] = outputs[problem.precheckOutputs[i]];
+        }
+        values->clear();
+        return SUCCESS;
+      }
+      case OP_GET_PRECHECK_VALUES:
+        *values = _precheckValues;
+        return SUCCESS;
+      default:
+        return EXCEL_INVALID_RETURN;
+    }
+  }
+
+ private:
+  std::vector<double> _vars;
+  std::vector<double> _cells;
+  std::vector<double> _values;
+  std::vector<double> _precheckValues;
+};
+
+bool StartStandInTransport() {
+  StopStandInTransport();
+  std::string name = "/OpenSolverNomad.si." + std::to_string(getpid());
+  standInTransport.reset(SharedMemoryTransport::Create(name));
+  int ready[2];
+  if (!standInTransport || pipe(ready) != 0) {
+    standInTransport.reset();
+    return false;
+  }
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    // Host process. It reports whether it attached, then serves until the
+    // solver closes the transport. _exit skips the destructor of the
+    // solver's copy of the transport.
+    close(ready[0]);
+    std::unique_ptr<SharedMemoryTransport> host(
+        SharedMemoryTransport::Open(name));
+    char attached = host ? 1 : 0;
+    bool reported = write(ready[1], &attached, 1) == 1;
+    close(ready[1]);
+    if (!host || !reported) {
+      _exit(EXIT_FAILURE);
+    }
+    StandInTransportHandler handler;
+    EXCEL_RC rc = host->Serve(&handler);
+    host.reset();
+    _exit(rc == SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  close(ready[1]);
+  char attached = 0;
+  if (pid == -1 || read(ready[0], &attached, 1) != 1 || !attached) {
+    attached = 0;
+  }
+  close(ready[0]);
+  if (!attached) {
+    standInTransport.reset();
+    if (pid != -1) {
+      waitpid(pid, nullptr, 0);
+    }
+    return false;
+  }
+  standInHostPid = pid;
+  return true;
+}
+
+bool StopStandInTransport() {
+  if (!standInTransport) {
+    return true;
+  }
+  // Closing the transport tells the host process to exit
+  standInTransport.reset();
+  int status = 0;
+  bool exited = waitpid(standInHostPid, &status, 0) == standInHostPid &&
+                WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+  standInHostPid = 0;
+  return exited;
+}
+
+// Fails a callback made from a thread other than the host thread
+EXCEL_RC CheckStandInThread(int location) {
+  if (std::this_thread::get_id() != standInHostThread) {
+    return AddLocationIfError(EXCEL_API_ERROR, location);
+  }
+  return SUCCESS;
+}
+
+// Each backend stands for a separate copy of the workbook, with its own cells
+class StandInBackend : public EvaluationBackend {
+ public:
+  StandInBackend() : _cells(standInProblem->startingX) {}
+
+  EXCEL_RC Evaluate(double* newVars, int /*numVars*/, int numCons,
+                    const double* /*bestSolution*/, bool /*feasibility*/,
+                    double* newCons) override {
+    if (numCons != standInProblem->numCons) {
+      return EXCEL_INVALID_RETURN;
+    }
+    EvaluateStandIn(&_cells, newVars, newCons);
+    return SUCCESS;
+  }
+
+ private:
+  std::vector<double> _cells;
+};
+
+EvaluationBackend* CreateStandInBackend(int /*workerIndex*/) {
+  return new StandInBackend();
+}
+
+// Interface implementations
+
+EXCEL_RC CheckForEscapeKeypress(bool /*fullCheck*/) {
+  EXCEL_RC rc = CheckStandInThread(CHECK_ESC_PRESS_NUM);
+  if (rc == SUCCESS && standInTransport) {
+    rc = TransportCheckForEscapeKeypress(standInTransport.get());
+  }
+  return rc;
+}
+
+EXCEL_RC GetLogFilePath(std::string* logPath) {
+  standInHostThread = std::this_thread::get_id();
+  *logPath = standInLogPath;
+  return SUCCESS;
+}
+
+EXCEL_RC GetNumConstraints(int* numCons, int* numObjs) {
+  *numCons = standInProblem->numCons;
+  *numObjs = standInProblem->numObjs;
+  return SUCCESS;
+}
+
+EXCEL_RC GetNumVariables(int* numVars) {
+  *numVars = standInProblem->numVars;
+  return SUCCESS;
+}
+
+EXCEL_RC GetVariableData(int numVars, double* lowerBounds, double* upperBounds,
+                         double* startingX, int* varTypes) {
+  if (numVars != standInProblem->numVars) {
+    return AddLocationIfError(EXCEL_INVALID_RETURN, GET_VARIABLE_DATA_NUM);
+  }
+  for (int i = 0; i < numVars; ++i) {
+    lowerBounds[i] = standInProblem->lowerBounds[i];
+    upperBounds[i] = standInProblem->upperBounds[i];
+    startingX[i] = standInProblem->startingX[i];
+    varTypes[i] = standInProblem->varTypes[i];
+  }
+  return SUCCESS;
+}
+
+EXCEL_RC GetOptionData(std::string** paramStrings, int* numOptions) {
+  *numOptions = static_cast<int>(standInOptions.size());
+  *paramStrings = new std::string[*numOptions];
+  for (int i = 0; i < *numOptions; ++i) {
+    (*paramStrings)[i] = standInOptions[i];
+  }
+  return SUCCESS;
+}
+
+EXCEL_RC GetUseWarmstart(bool* useWarmstart) {
+  *useWarmstart = standInWarmstart;
+  return SUCCESS;
+}
+
+EXCEL_RC GetProblemDescriptor(ProblemDescriptor* problem) {
+  standInHostThread = std::this_thread::get_id();
+  problem->logPath = standInLogPath;
+  problem->numVars = standInProblem->numVars;
+  problem->lowerBounds = standInProblem->lowerBounds;
+  problem->upperBounds = standInProblem->upperBounds;
+  problem->startingX = standInProblem->startingX;
+  problem->varTypes = standInProblem->varTypes;
+  problem->numCons = standInProblem->numCons;
+  problem->numObjs = standInProblem->numObjs;
+  problem->options = standInOptions;
+  problem->useWarmstart = standInWarmstart;
+  problem->precheckOutputs = standInProblem->precheckOutputs;
+  problem->hasSurrogate = (standInProblem->surrogate != nullptr);
+  return SUCCESS;
+}
+
+EXCEL_RC GetPrecheckOutputs(std::vector<int>* outputs) {
+  *outputs = standInProblem->precheckOutputs;
+  return SUCCESS;
+}
+
+EXCEL_RC GetHasSurrogate(bool* hasSurrogate) {
+  *hasSurrogate = (standInProblem->surrogate != nullptr);
+  return SUCCESS;
+}
+
+EXCEL_RC UpdateVars(double* newVars, int numVars,
+                    const double* bestSolution, bool feasibility) {
+  if (numVars != standInProblem->numVars) {
+    return AddLocationIfError(EXCEL_INVALID_RETURN, UPDATE_VARS_NUM);
+  }
+  EXCEL_RC rc = CheckStandInThread(UPDATE_VARS_NUM);
+  if (rc != SUCCESS) {
+    return rc;
+  }
+  standInVars.assign(newVars, newVars + numVars);
+  if (standInTransport) {
+    rc = TransportUpdateVars(standInTransport.get(), newVars, numVars,
+                             bestSolution, feasibility);
+  }
+  return rc;
+}
+
+// Over the transport the values are fetched straight away, so that the
+// evaluation can be traced in this process
+EXCEL_RC RecalculateValues() {
+  EXCEL_RC rc = CheckStandInThread(RECALCULATE_VALUES_NUM);
+  if (rc != SUCCESS) {
+    return rc;
+  }
+  if (!standInTransport) {
+    EvaluateStandIn(&standInCells, standInVars.data(), standInValues.data());
+    return SUCCESS;
+  }
+  rc = TransportRecalculateValues(standInTransport.get());
+  if (rc == SUCCESS) {
+    rc = TransportGetConstraintValues(standInTransport.get(),
+                                      standInProblem->numCons,
+                                      standInValues.data());
+  }
+  if (rc == SUCCESS) {
+    TraceStandIn(standInValues.data());
+  }
+  return rc;
+}
+
+// Low-fidelity values aren't traced, so the trace only holds full evaluations
+EXCEL_RC RecalculateSurrogate() {
+  EXCEL_RC rc = CheckStandInThread(RECALCULATE_SURROGATE_NUM);
+  if (rc != SUCCESS) {
+    return rc;
+  }
+  if (standInProblem->surrogate == nullptr) {
+    return AddLocationIfError(EXCEL_VBA_ERROR, RECALCULATE_SURROGATE_NUM);
+  }
+  if (standInTransport) {
+    rc = TransportRecalculateSurrogate(standInTransport.get());
+    if (rc == SUCCESS) {
+      rc = TransportGetConstraintValues(standInTransport.get(),
+                                        standInProblem->numCons,
+                                        standInValues.data());
+    }
+    return rc;
+  }
+  WaitForStandInLatency(STAND_IN_SURROGATE_COST,
+                        UpdateStandInCells(&standInCells, standInVars.data()));
+  standInProblem->surrogate(standInVars.data(), standInValues.data());
+  return SUCCESS;
+}
+
+EXCEL_RC GetConstraintValues(int numCons, double* newCons) {
+  if (numCons != standInProblem->numCons) {
+    return AddLocationIfError(EXCEL_INVALID_RETURN, GET_CONSTRAINT_VALUES_NUM);
+  }
+  EXCEL_RC rc = CheckStandInThread(GET_CONSTRAINT_VALUES_NUM);
+  if (rc != SUCCESS) {
+    return rc;
+  }
+  for (int i = 0; i < numCons; ++i) {
+    newCons[i] = standInValues[i];
+  }
+  return SUCCESS;
+}
+
+// A pre-check stands for a cheap partial recalculation, so it neither waits
+// for the latency nor is traced as an evaluation
+EXCEL_RC RecalculatePrecheck() {
+  EXCEL_RC rc = CheckStandInThread(RECALCULATE_PRECHECK_NUM);
+  if (rc != SUCCESS) {
+    return rc;
+  }
+  if (standInTransport) {
+    standInPrecheckValues.resize(standInProblem->precheckOutputs.size());
+    rc = TransportRecalculatePrecheck(standInTransport.get());
+    if (rc == SUCCESS) {
+      rc = TransportGetPrecheckValues(
+          standInTransport.get(),
+          static_cast<int>(standInPrecheckValues.size()),
+          standInPrecheckValues.data());
+    }
+    return rc;
+  }
+  std::vector<double> values(standInProblem->numCons);
+  standInProblem->evaluate(standInVars.data(), values.data());
+  standInPrecheckValues.clear();
+  for (size_t i = 0; i < standInProblem->precheckOutputs.size(); ++i) {
+    standInPrecheckValues.push_back(
+        values[standInProblem->precheckOutputs[i]]);
+  }
+  return SUCCESS;
+}
+
+EXCEL_RC GetPrecheckValues(int numPrecheck, double* values) {
+  if (numPrecheck != static_cast<int>(standInPrecheckValues.size())) {
+    return AddLocationIfError(EXCEL_INVALID_RETURN, GET_PRECHECK_VALUES_NUM);
+  }
+  EXCEL_RC rc = CheckStandInThread(GET_PRECHECK_VALUES_NUM);
+  if (rc != SUCCESS) {
+    return rc;
+  }
+  for (int i = 0; i < numPrecheck; ++i) {
+    values[i] = standInPrecheckValues[i];
+  }
+  return SUCCESS;
+}
+
+EXCEL_RC GetNumScenarios(int* numScenarios) {
+  if (standInScenarios == nullptr) {
+    return AddLocationIfError(EXCEL_VBA_ERROR, GET_NUM_SCENARIOS_NUM);
+  }
+  *numScenarios = static_cast<int>(standInScenarios->size());
+  return SUCCESS;
+}
+
+// The trace runs on across scenarios, as in a single solve. The host process
+// only knows the first problem, so batches can't run over the transport.
+EXCEL_RC ApplyScenario(int scenario, std::vector<double>* parameters) {
+  if (standInScenarios == nullptr || standInTransport || scenario < 0 ||
+      scenario >= static_cast<int>(standInScenarios->size())) {
+    return AddLocationIfError(EXCEL_VBA_ERROR, APPLY_SCENARIO_NUM);
+  }
+  const StandInScenario& current = (*standInScenarios)[scenario];
+  standInProblem = current.problem;
+  standInVars = standInProblem->startingX;
+  standInCells = standInProblem->startingX;
+  standInValues.assign(standInProblem->numCons, 0.0);
+  *parameters = current.parameters;
+  return SUCCESS;
+}
+
+EXCEL_RC LoadScenarioResults(int numRows, int numColumns,
+                             const double* table) {
+  standInScenarioResults.assign(numRows, std::vector<double>());
+  for (int r = 0; r < numRows; ++r) {
+    standInScenarioResults[r].assign(table + r * numColumns,
+                                     table + (r + 1) * numColumns);
+  }
+  return SUCCESS;
+}
+
+void LoadResult(int /*retVal*/) {
+  // The caller reads the result through GetStandInVars and GetStandInTrace
+}
+
+}  // namespace OPENSOLVER
@@ -9,9 +9,11 @@
 #include <xlcall.h>
 #include <framewrk.h>
 
+#include <cmath>
 #include <cstdlib>
 #include <limits>
 #include <string>
+#include <vector>
 
 namespace OPENSOLVER {
 
@@ -295,6 +297,141 @@ EXCEL_RC GetUseWarmstart(bool* useWarmstart) {
   return AddLocationIfError(rc, GET_USE_WARMSTART);
 }
 
+EXCEL_RC GetProblemDescriptor(ProblemDescriptor* problem) {
+  static XCHAR GetProblemDescriptorName[WCHARBUF];
+  ConvertToXcharIfNeeded(GetProblemDescriptorName,
+                         GET_PROBLEM_DESCRIPTOR_NAME);
+
+  static XLOPER12 xResult;
+  int ret = Excel12f(xlUDF, &xResult, 1, TempStr12(GetProblemDescriptorName));
+
+  // The result is a single row packed as: log path string and length, number
+  // of variables, number of constraints, number of objectives, warmstart,
+  // number of pre-check outputs, whether there is a low-fidelity mode, then
+  // the variable data as in GetVariableData, the pre-check outputs as in
+  // GetPrecheckOutputs, and finally each option string and its length.
+  const int headerSize = 8;
+  EXCEL_RC rc = CheckReturn(ret, xResult);
+  if (rc == SUCCESS && xResult.xltype != xltypeMulti) {
+    rc = EXCEL_INVALID_RETURN;
+  }
+  if (rc == SUCCESS) {
+    const XLOPER12* data = xResult.val.array.lparray;
+    int size = xResult.val.array.rows * xResult.val.array.columns;
+    if (size < headerSize ||
+        data[2].xltype != xltypeNum || data[3].xltype != xltypeNum ||
+        data[4].xltype != xltypeNum || data[5].xltype != xltypeBool ||
+        data[6].xltype != xltypeNum || data[7].xltype != xltypeBool) {
+      rc = EXCEL_INVALID_RETURN;
+    } else {
+      rc = GetStringFromExcel(data, &problem->logPath);
+    }
+    if (rc == SUCCESS) {
+      int numVars = static_cast<int>(data[2].val.num);
+      int numPrecheck = static_cast<int>(data[6].val.num);
+      int numOptionValues = size - headerSize - 4 * numVars - numPrecheck;
+      if (numVars < 0 || numPrecheck < 0 || numOptionValues < 0 ||
+          numOptionValues % 2 != 0) {
+        rc = EXCEL_INVALID_RETURN;
+      } else {
+        problem->numVars = numVars;
+        problem->numCons = static_cast<int>(data[3].val.num);
+        problem->numObjs = static_cast<int>(data[4].val.num);
+        problem->useWarmstart = (data[5].val.xbool != 0);
+        problem->hasSurrogate = (data[7].val.xbool != 0);
+
+        const XLOPER12* varData = data + headerSize;
+        problem->lowerBounds.resize(numVars);
+        problem->upperBounds.resize(numVars);
+        problem->startingX.resize(numVars);
+        problem->varTypes.resize(numVars);
+        for (int i = 0; i < numVars; i++) {
+          problem->lowerBounds[i] = varData[0 * numVars + i].val.num;
+          problem->upperBounds[i] = varData[1 * numVars + i].val.num;
+          problem->startingX[i] =   varData[2 * numVars + i].val.num;
+          double rawType = varData[3 * numVars + i].val.num;
+          problem->varTypes[i] = static_cast<int>(rawType);
+        }
+
+        const XLOPER12* precheckData = varData + 4 * numVars;
+        problem->precheckOutputs.resize(numPrecheck);
+        for (int i = 0; i < numPrecheck; i++) {
+          problem->precheckOutputs[i] =
+              static_cast<int>(precheckData[i].val.num);
+        }
+
+        const XLOPER12* optionData = precheckData + numPrecheck;
+        problem->options.resize(numOptionValues / 2);
+        for (size_t i = 0; i < problem->options.size(); ++i) {
+          rc = GetStringFromExcel(optionData + 2 * i, &problem->options[i]);
+          if (rc != SUCCESS) {
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  // Free Excel-allocated memory
+  Excel12f(xlFree, nullptr, 1, &xResult);
+
+  return AddLocationIfError(rc, GET_PROBLEM_DESCRIPTOR_NUM);
+}
+
+EXCEL_RC GetPrecheckOutputs(std::vector<int>* outputs) {
+  static XCHAR GetPrecheckOutputsName[WCHARBUF];
+  ConvertToXcharIfNeeded(GetPrecheckOutputsName, GET_PRECHECK_OUTPUTS_NAME);
+
+  static XLOPER12 xResult;
+  int ret = Excel12f(xlUDF, &xResult, 1, TempStr12(GetPrecheckOutputsName));
+
+  // A single zero means there are no pre-check outputs
+  EXCEL_RC rc = CheckReturn(ret, xResult);
+  outputs->clear();
+  if (rc == SUCCESS) {
+    if (xResult.xltype == xltypeMulti) {
+      int size = xResult.val.array.rows * xResult.val.array.columns;
+      for (int i = 0; i < size; i++) {
+        if (xResult.val.array.lparray[i].xltype != xltypeNum) {
+          rc = EXCEL_INVALID_RETURN;
+          break;
+        }
+        outputs->push_back(
+            static_cast<int>(xResult.val.array.lparray[i].val.num));
+      }
+    } else if (xResult.xltype != xltypeNum || xResult.val.num != 0) {
+      rc = EXCEL_INVALID_RETURN;
+    }
+  }
+
+  // Free Excel-allocated memory
+  Excel12f(xlFree, nullptr, 1, &xResult);
+
+  return AddLocationIfError(rc, GET_PRECHECK_OUTPUTS_NUM);
+}
+
+EXCEL_RC GetHasSurrogate(bool* hasSurrogate) {
+  static XCHAR GetHasSurrogateName[WCHARBUF];
+  ConvertToXcharIfNeeded(GetHasSurrogateName, GET_HAS_SURROGATE_NAME);
+
+  static XLOPER12 xResult;
+  int ret = Excel12f(xlUDF, &xResult, 1, TempStr12(GetHasSurrogateName));
+
+  EXCEL_RC rc = CheckReturn(ret, xResult);
+  if (rc == SUCCESS) {
+    if (xResult.xltype == xltypeBool) {
+      *hasSurrogate = (xResult.val.xbool != 0);
+    } else {
+      rc = EXCEL_INVALID_RETURN;
+    }
+  }
+
+  // Free Excel-allocated memory
+  Excel12f(xlFree, nullptr, 1, &xResult);
+
+  return AddLocationIfError(rc, GET_HAS_SURROGATE_NUM);
+}
+
 EXCEL_RC UpdateVars(double* newVars, int numVars, const double* bestSolution,
                 bool feasibility) {
   // Set up the variant array of new variable values.
@@ -393,4 +530,167 @@ EXCEL_RC GetConstraintValues(int numCons, double* newCons) {
   return AddLocationIfError(rc, GET_CONSTRAINT_VALUES_NUM);
 }
 
+EXCEL_RC RecalculatePrecheck() {
+  static XCHAR RecalculatePrecheckName[WCHARBUF];
+  ConvertToXcharIfNeeded(RecalculatePrecheckName, RECALCULATE_PRECHECK_NAME);
+
+  static XLOPER12 xResult;
+  int ret = Excel12f(xlUDF, &xResult, 1, TempStr12(RecalculatePrecheckName));
+
+  EXCEL_RC rc = CheckReturn(ret, xResult);
+  if (rc == SUCCESS) {
+    if (xResult.xltype != xltypeNum || xResult.val.num != 0) {
+      rc = EXCEL_INVALID_RETURN;
+    }
+  }
+
+  // Free Excel-allocated memory
+  Excel12f(xlFree, nullptr, 1, &xResult);
+
+  return AddLocationIfError(rc, RECALCULATE_PRECHECK_NUM);
+}
+
+EXCEL_RC GetPrecheckValues(int numPrecheck, double* values) {
+  static XCHAR GetPrecheckValuesName[WCHARBUF];
+  ConvertToXcharIfNeeded(GetPrecheckValuesName, GET_PRECHECK_VALUES_NAME);
+
+  static XLOPER12 xResult;
+  int ret = Excel12f(xlUDF, &xResult, 1, TempStr12(GetPrecheckValuesName));
+
+  EXCEL_RC rc = CheckReturn(ret, xResult);
+  if (rc == SUCCESS) {
+    if (CheckIsArray(xResult, numPrecheck)) {
+      for (int i = 0; i < numPrecheck; i++) {
+        // Errors are NaN, as in GetConstraintValues
+        if (xResult.val.array.lparray[i].xltype != xltypeNum) {
+          values[i] = std::numeric_limits<double>::quiet_NaN();
+        } else {
+          values[i] = xResult.val.array.lparray[i].val.num;
+        }
+      }
+    } else {
+      rc = EXCEL_INVALID_RETURN;
+    }
+  }
+
+  // Free memory allocated by Excel
+  Excel12f(xlFree, nullptr, 1, &xResult);
+
+  return AddLocationIfError(rc, GET_PRECHECK_VALUES_NUM);
+}
+
+EXCEL_RC RecalculateSurrogate() {
+  static XCHAR RecalculateSurrogateName[WCHARBUF];
+  ConvertToXcharIfNeeded(RecalculateSurrogateName, RECALCULATE_SURROGATE_NAME);
+
+  static XLOPER12 xResult;
+  int ret = Excel12f(xlUDF, &xResult, 1, TempStr12(RecalculateSurrogateName));
+
+  EXCEL_RC rc = CheckReturn(ret, xResult);
+  if (rc == SUCCESS) {
+    if (xResult.xltype != xltypeNum || xResult.val.num != 0) {
+      rc = EXCEL_INVALID_RETURN;
+    }
+  }
+
+  // Free Excel-allocated memory
+  Excel12f(xlFree, nullptr, 1, &xResult);
+
+  return AddLocationIfError(rc, RECALCULATE_SURROGATE_NUM);
+}
+
+EXCEL_RC GetNumScenarios(int* numScenarios) {
+  static XCHAR GetNumScenariosName[WCHARBUF];
+  ConvertToXcharIfNeeded(GetNumScenariosName, GET_NUM_SCENARIOS_NAME);
+
+  static XLOPER12 xResult;
+  int ret = Excel12f(xlUDF, &xResult, 1, TempStr12(GetNumScenariosName));
+
+  EXCEL_RC rc = CheckReturn(ret, xResult);
+  if (rc == SUCCESS) {
+    if (xResult.xltype == xltypeNum) {
+      *numScenarios = static_cast<int>(xResult.val.num);
+    } else {
+      rc = EXCEL_INVALID_RETURN;
+    }
+  }
+
+  // Free Excel-allocated memory
+  Excel12f(xlFree, nullptr, 1, &xResult);
+
+  return AddLocationIfError(rc, GET_NUM_SCENARIOS_NUM);
+}
+
+EXCEL_RC ApplyScenario(int scenario, std::vector<double>* parameters) {
+  static XCHAR ApplyScenarioName[WCHARBUF];
+  ConvertToXcharIfNeeded(ApplyScenarioName, APPLY_SCENARIO_NAME);
+
+  static XLOPER12 xResult;
+  int ret = Excel12f(xlUDF, &xResult, 2, TempStr12(ApplyScenarioName),
+                     TempNum12(scenario));
+
+  // A single zero means the scenario has no parameters
+  EXCEL_RC rc = CheckReturn(ret, xResult);
+  parameters->clear();
+  if (rc == SUCCESS) {
+    if (xResult.xltype == xltypeMulti) {
+      int size = xResult.val.array.rows * xResult.val.array.columns;
+      for (int i = 0; i < size; i++) {
+        if (xResult.val.array.lparray[i].xltype != xltypeNum) {
+          rc = EXCEL_INVALID_RETURN;
+          break;
+        }
+        parameters->push_back(xResult.val.array.lparray[i].val.num);
+      }
+    } else if (xResult.xltype != xltypeNum || xResult.val.num != 0) {
+      rc = EXCEL_INVALID_RETURN;
+    }
+  }
+
+  // Free Excel-allocated memory
+  Excel12f(xlFree, nullptr, 1, &xResult);
+
+  return AddLocationIfError(rc, APPLY_SCENARIO_NUM);
+}
+
+EXCEL_RC LoadScenarioResults(int numRows, int numColumns,
+                             const double* table) {
+  // Set up the variant array of the table, with NaN as Empty
+  int size = numRows * numColumns;
+  XLOPER12 *xOpArray = new XLOPER12[size];
+  for (int i = 0; i < size; i++) {
+    if (std::isnan(table[i])) {
+      xOpArray[i].xltype = xltypeNil;
+    } else {
+      xOpArray[i].xltype = xltypeNum;
+      xOpArray[i].val.num = table[i];
+    }
+  }
+
+  XLOPER12 xOpMulti;
+  xOpMulti.xltype = xltypeMulti|xlbitDLLFree;
+  xOpMulti.val.array.lparray = xOpArray;
+  xOpMulti.val.array.columns = static_cast<COL>(numColumns);
+  xOpMulti.val.array.rows = static_cast<RW>(numRows);
+
+  static XCHAR LoadScenarioResultsName[WCHARBUF];
+  ConvertToXcharIfNeeded(LoadScenarioResultsName, LOAD_SCENARIO_RESULTS_NAME);
+
+  static XLOPER12 xResult;
+  int ret = Excel12f(xlUDF, &xResult, 2, TempStr12(LoadScenarioResultsName),
+                     &xOpMulti);
+  EXCEL_RC rc = CheckReturn(ret, xResult);
+  if (rc == SUCCESS) {
+    if (xResult.xltype != xltypeNum || xResult.val.num != 0) {
+      rc = EXCEL_INVALID_RETURN;
+    }
+  }
+
+  delete[] xOpArray;
+  // Free Excel-allocated memory
+  Excel12f(xlFree, nullptr, 1, &xResult);
+
+  return AddLocationIfError(rc, LOAD_SCENARIO_RESULTS_NUM);
+}
+
 }  // namespace OPENSOLVER
@@ -0,0 +1,107 @@
+// HiddenConstraintModel.cpp
+
+#include "HiddenConstraintModel.hpp"
+
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace OPENSOLVER {
+
+// Most points kept in the model, after which the oldest are replaced
+const int MAX_MODEL_POINTS = 5000;
+
+// Every this many predicted failures, one is evaluated anyway
+const int PREDICTION_CHECK_INTERVAL = 10;
+
+HiddenConstraintModel::HiddenConstraintModel(const std::vector<double>& scales,
+                                             int numNeighbours) :
+    _n(static_cast<int>(scales.size())),
+    _numNeighbours(numNeighbours),
+    _invScales(scales.size()),
+    _next(0),
+    _numFailed(0),
+    _numPredicted(0),
+    _numSkipped(0) {
+  for (int i = 0; i < _n; ++i) {
+    _invScales[i] = (scales[i] > 0 && std::isfinite(scales[i]))
+                    ? 1.0 / scales[i] : 1.0;
+  }
+}
+
+void HiddenConstraintModel::AddPoint(const double* x, bool failed) {
+  if (failed) {
+    ++_numFailed;
+  }
+
+  int row;
+  if (static_cast<int>(_failed.size()) < MAX_MODEL_POINTS) {
+    row = static_cast<int>(_failed.size());
+    _failed.push_back(failed);
+    _points.resize(_points.size() + _n);
+  } else {
+    row = _next;
+    _next = (_next + 1) % MAX_MODEL_POINTS;
+    _failed[row] = failed;
+  }
+
+  double* point = &_points[static_cast<size_t>(row) * _n];
+  for (int i = 0; i < _n; ++i) {
+    point[i] = x[i] * _invScales[i];
+  }
+}
+
+bool HiddenConstraintModel::PredictFailure(const double* x) const {
+  // Nothing to learn from until we have seen enough failures
+  if (_numFailed < _numNeighbours) {
+    return false;
+  }
+
+  // Keep the nearest neighbours sorted by distance, nearest first
+  typedef std::pair<double, bool> Neighbour;
+  std::vector<Neighbour> nearest(_numNeighbours,
+      Neighbour(std::numeric_limits<double>::infinity(), false));
+
+  const int numPoints = static_cast<int>(_failed.size());
+  for (int row = 0; row < numPoints; ++row) {
+    const double* point = &_points[static_cast<size_t>(row) * _n];
+    const double worst = nearest.back().first;
+    double dist = 0;
+    for (int i = 0; i < _n && dist < worst; ++i) {
+      double d = x[i] * _invScales[i] - point[i];
+      dist += d * d;
+    }
+    if (dist >= worst) {
+      continue;
+    }
+
+    int j = _numNeighbours - 1;
+    while (j > 0 && nearest[j - 1].first > dist) {
+      nearest[j] = nearest[j - 1];
+      --j;
+    }
+    nearest[j] = Neighbour(dist, _failed[row]);
+  }
+
+  // Only predict a failure if every neighbour failed
+  for (int j = 0; j < _numNeighbours; ++j) {
+    if (!nearest[j].second) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool HiddenConstraintModel::ShouldSkip(const double* x) {
+  if (!PredictFailure(x)) {
+    return false;
+  }
+  if (++_numPredicted % PREDICTION_CHECK_INTERVAL == 0) {
+    return false;
+  }
+  ++_numSkipped;
+  return true;
+}
+
+}  // namespace OPENSOLVER
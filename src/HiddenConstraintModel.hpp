@@ -0,0 +1,64 @@
+// HiddenConstraintModel.hpp
+// Predicts which points will fail to evaluate in Excel
+//
+// A point fails when any of its constraint cells is an Excel error, which
+// GetConstraintValues returns as NaN. The model is a nearest-neighbour vote
+// over the points evaluated so far, with each variable scaled by its range.
+
+#ifndef SRC_HIDDENCONSTRAINTMODEL_H_
+#define SRC_HIDDENCONSTRAINTMODEL_H_
+
+#include <vector>
+
+namespace OPENSOLVER {
+
+class HiddenConstraintModel {
+ public:
+  /**
+   * @param scales The range of each variable, used to scale distances
+   * @param numNeighbours The number of neighbours that must all have failed
+   *                      for a point to be predicted to fail
+   */
+  HiddenConstraintModel(const std::vector<double>& scales, int numNeighbours);
+
+  /**
+   * Adds the result of an evaluation to the model
+   *
+   * @param x The variable values of the point
+   * @param failed True if the point gave an Excel error
+   */
+  void AddPoint(const double* x, bool failed);
+
+  /**
+   * Decides whether a point should be skipped as a predicted failure
+   *
+   * Every so often a predicted failure is let through anyway so that a wrong
+   * model can still be corrected.
+   * @param x The variable values of the point
+   * @return True if the point should not be evaluated
+   */
+  bool ShouldSkip(const double* x);
+
+  // Number of evaluations (and so recalculations) skipped
+  int GetNumSkipped() const { return _numSkipped; }
+
+  // Number of evaluations that failed in Excel
+  int GetNumFailed() const { return _numFailed; }
+
+ private:
+  bool PredictFailure(const double* x) const;
+
+  int                  _n;
+  int                  _numNeighbours;
+  std::vector<double>  _invScales;
+  std::vector<double>  _points;   // Scaled points, stored row by row
+  std::vector<bool>    _failed;
+  int                  _next;     // Row to overwrite once the model is full
+  int                  _numFailed;
+  int                  _numPredicted;
+  int                  _numSkipped;
+};
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_HIDDENCONSTRAINTMODEL_H_
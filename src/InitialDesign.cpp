@@ -0,0 +1,167 @@
+// InitialDesign.cpp
+
+#include "InitialDesign.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "NomadInterface.hpp"
+
+namespace OPENSOLVER {
+
+// Width of the window sampled for a variable missing a bound, relative to
+// the size of the bound it does have
+const double UNBOUNDED_WINDOW = 10;
+
+// Fixed so that the same model always gets the same design
+const unsigned int DESIGN_SEED = 1;
+
+const int SOBOL_BITS = 32;
+
+// Primitive polynomials and initial direction numbers of Joe and Kuo for
+// Sobol dimensions 2 onwards. The first dimension uses all ones.
+struct SobolDirections {
+  int       degree;
+  unsigned  coefficients;  // Inner polynomial coefficients, highest first
+  unsigned  initial[7];
+};
+
+const SobolDirections SOBOL_DIRECTIONS[MAX_SOBOL_DIMENSION - 1] = {
+  {1, 0,  {1}},
+  {2, 1,  {1, 3}},
+  {3, 1,  {1, 3, 1}},
+  {3, 2,  {1, 1, 1}},
+  {4, 1,  {1, 1, 3, 3}},
+  {4, 4,  {1, 3, 5, 13}},
+  {5, 2,  {1, 1, 5, 5, 17}},
+  {5, 4,  {1, 1, 5, 5, 5}},
+  {5, 7,  {1, 1, 7, 11, 19}},
+  {5, 11, {1, 1, 5, 1, 1}},
+  {5, 13, {1, 1, 1, 3, 11}},
+  {5, 14, {1, 3, 5, 5, 31}},
+  {6, 1,  {1, 3, 3, 9, 7, 49}},
+  {6, 13, {1, 1, 1, 15, 21, 21}},
+  {6, 16, {1, 3, 1, 13, 27, 49}},
+  {6, 19, {1, 1, 1, 15, 7, 5}},
+  {6, 22, {1, 3, 1, 15, 13, 25}},
+  {6, 25, {1, 1, 5, 5, 19, 61}},
+  {7, 1,  {1, 3, 7, 11, 23, 15, 103}},
+  {7, 4,  {1, 3, 7, 13, 13, 15, 69}}
+};
+
+// Gets the direction numbers of a Sobol dimension, scaled to SOBOL_BITS
+std::vector<uint32_t> GetSobolDirections(int dimension) {
+  std::vector<uint32_t> v(SOBOL_BITS + 1);
+  if (dimension == 0) {
+    for (int k = 1; k <= SOBOL_BITS; ++k) {
+      v[k] = 1u << (SOBOL_BITS - k);
+    }
+    return v;
+  }
+
+  const SobolDirections& d = SOBOL_DIRECTIONS[dimension - 1];
+  const int s = d.degree;
+  for (int k = 1; k <= s; ++k) {
+    v[k] = d.initial[k - 1] << (SOBOL_BITS - k);
+  }
+  for (int k = s + 1; k <= SOBOL_BITS; ++k) {
+    v[k] = v[k - s] ^ (v[k - s] >> s);
+    for (int j = 1; j < s; ++j) {
+      if ((d.coefficients >> (s - 1 - j)) & 1) {
+        v[k] ^= v[k - j];
+      }
+    }
+  }
+  return v;
+}
+
+// Unit points of a Sobol sequence, skipping the first point at the origin
+std::vector<std::vector<double> > CreateSobolPoints(int numPoints, int n) {
+  std::vector<std::vector<double> > points(numPoints, std::vector<double>(n));
+  for (int i = 0; i < n; ++i) {
+    std::vector<uint32_t> v = GetSobolDirections(i);
+    for (int k = 0; k < numPoints; ++k) {
+      uint32_t index = static_cast<uint32_t>(k + 1);
+      uint32_t gray = index ^ (index >> 1);
+      uint32_t x = 0;
+      for (int bit = 1; gray != 0; ++bit, gray >>= 1) {
+        if (gray & 1) {
+          x ^= v[bit];
+        }
+      }
+      points[k][i] = std::ldexp(static_cast<double>(x), -SOBOL_BITS);
+    }
+  }
+  return points;
+}
+
+// Unit points with each variable split into numPoints strata, one point in
+// each stratum
+std::vector<std::vector<double> > CreateLatinHypercubePoints(int numPoints,
+                                                             int n) {
+  std::mt19937 rng(DESIGN_SEED);
+  std::uniform_real_distribution<double> offset(0, 1);
+  std::vector<std::vector<double> > points(numPoints, std::vector<double>(n));
+  std::vector<int> strata(numPoints);
+  for (int i = 0; i < n; ++i) {
+    for (int k = 0; k < numPoints; ++k) {
+      strata[k] = k;
+    }
+    std::shuffle(strata.begin(), strata.end(), rng);
+    for (int k = 0; k < numPoints; ++k) {
+      points[k][i] = (strata[k] + offset(rng)) / numPoints;
+    }
+  }
+  return points;
+}
+
+std::vector<std::vector<double> > CreateInitialDesign(
+    InitialDesignType type, int numPoints,
+    const std::vector<double>& lowerBounds,
+    const std::vector<double>& upperBounds, const std::vector<int>& varTypes) {
+  const int n = static_cast<int>(varTypes.size());
+
+  std::vector<std::vector<double> > points;
+  if (type == MIDPOINT_DESIGN || numPoints < 1) {
+    points.assign(1, std::vector<double>(n, 0.5));
+  } else if (type == SOBOL_DESIGN && n <= MAX_SOBOL_DIMENSION) {
+    points = CreateSobolPoints(numPoints, n);
+  } else {
+    points = CreateLatinHypercubePoints(numPoints, n);
+  }
+
+  // Map the unit cube onto the bounds
+  for (int i = 0; i < n; ++i) {
+    bool hasLower = lowerBounds[i] > -1e10;
+    bool hasUpper = upperBounds[i] < 1e10;
+    double lower = lowerBounds[i];
+    double upper = upperBounds[i];
+    if (hasLower && !hasUpper) {
+      upper = lower + UNBOUNDED_WINDOW * std::max(1.0, std::fabs(lower));
+    } else if (!hasLower && hasUpper) {
+      lower = upper - UNBOUNDED_WINDOW * std::max(1.0, std::fabs(upper));
+    } else if (!hasLower && !hasUpper) {
+      lower = -UNBOUNDED_WINDOW / 2;
+      upper = UNBOUNDED_WINDOW / 2;
+    }
+
+    for (size_t k = 0; k < points.size(); ++k) {
+      double u = points[k][i];
+      if (varTypes[i] == CONTINUOUS) {
+        points[k][i] = lower + u * (upper - lower);
+      } else {
+        // Each integer value gets an equal share of the unit interval
+        double first = std::ceil(lower);
+        double last = std::floor(upper);
+        double value = first + std::floor(u * (last - first + 1));
+        points[k][i] = std::max(first, std::min(value, last));
+      }
+    }
+  }
+  return points;
+}
+
+}  // namespace OPENSOLVER
@@ -0,0 +1,47 @@
+// InitialDesign.hpp
+// Space-filling starting points for solves without a warm start
+//
+// Without a warm start, the solve used to begin at the midpoint of the
+// bounds, which is a single point and is infinite for unbounded variables.
+// A Latin hypercube or Sobol design spreads several points over the box
+// instead. NOMAD evaluates all of them as starting points and continues from
+// the best. Unbounded variables are sampled over a finite window next to
+// their finite bound, or around zero.
+
+#ifndef SRC_INITIALDESIGN_H_
+#define SRC_INITIALDESIGN_H_
+
+#include <vector>
+
+namespace OPENSOLVER {
+
+enum InitialDesignType {
+  MIDPOINT_DESIGN,        // The midpoint of the (windowed) bounds only
+  LATIN_HYPERCUBE_DESIGN,
+  SOBOL_DESIGN
+};
+
+// Largest dimension we have Sobol direction numbers for. Larger models use a
+// Latin hypercube instead.
+const int MAX_SOBOL_DIMENSION = 21;
+
+/**
+ * Creates the starting points of a solve
+ *
+ * Integer and binary variables are spread evenly over their integer values.
+ * The design is the same every time for the same model.
+ * @param type The kind of design, see InitialDesignType
+ * @param numPoints The number of points, ignored for MIDPOINT_DESIGN
+ * @param lowerBounds The lower bound of each variable
+ * @param upperBounds The upper bound of each variable, >= 1e10 if unbounded
+ * @param varTypes The type of each variable, see VarType
+ * @return The points of the design, one vector of variable values each
+ */
+std::vector<std::vector<double> > CreateInitialDesign(
+    InitialDesignType type, int numPoints,
+    const std::vector<double>& lowerBounds,
+    const std::vector<double>& upperBounds, const std::vector<int>& varTypes);
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_INITIALDESIGN_H_
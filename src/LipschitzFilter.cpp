@@ -0,0 +1,202 @@
+// LipschitzFilter.cpp
+
+#include "LipschitzFilter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace OPENSOLVER {
+
+// Most points kept in the filter, after which the oldest are replaced
+const int MAX_FILTER_POINTS = 5000;
+
+// Most values (variables and outputs) kept over all points
+const int MAX_FILTER_VALUES = 4 * 1024 * 1024;
+
+// Every this many predicted rejections, one is evaluated anyway
+const int REJECTION_CHECK_INTERVAL = 10;
+
+// Most rejected points kept for the report
+const int MAX_RECORDED_REJECTIONS = 10;
+
+LipschitzFilter::LipschitzFilter(const std::vector<double>& scales,
+                                 int numCons, int numObjs, int numNeighbours,
+                                 double safetyFactor) :
+    _n(static_cast<int>(scales.size())),
+    _m(numCons),
+    _numObjs(numObjs),
+    _numNeighbours(numNeighbours),
+    _safetyFactor(safetyFactor),
+    _invScales(scales.size()),
+    _numPoints(0),
+    _next(0),
+    _checkPending(false),
+    _checkOutput(0),
+    _checkBound(0),
+    _numPredicted(0),
+    _numSkipped(0),
+    _numSkippedObjective(0),
+    _numChecked(0),
+    _numBoundsBroken(0) {
+  for (int i = 0; i < _n; ++i) {
+    _invScales[i] = (scales[i] > 0 && std::isfinite(scales[i]))
+                    ? 1.0 / scales[i] : 1.0;
+  }
+  _maxPoints = std::min(MAX_FILTER_POINTS,
+                        std::max(_numNeighbours + 1,
+                                 MAX_FILTER_VALUES / std::max(_n + _m, 1)));
+}
+
+void LipschitzFilter::AddPoint(const double* x, const double* outputs) {
+  for (int i = 0; i < _m; ++i) {
+    if (std::isnan(outputs[i])) {
+      return;
+    }
+  }
+
+  if (_checkPending && std::equal(_checkX.begin(), _checkX.end(), x)) {
+    _checkPending = false;
+    if (outputs[_checkOutput] < _checkBound) {
+      ++_numBoundsBroken;
+    }
+  }
+
+  int row;
+  if (_numPoints < _maxPoints) {
+    row = _numPoints++;
+    _points.resize(_points.size() + _n);
+    _outputs.resize(_outputs.size() + _m);
+  } else {
+    row = _next;
+    _next = (_next + 1) % _maxPoints;
+  }
+
+  double* point = &_points[static_cast<size_t>(row) * _n];
+  for (int i = 0; i < _n; ++i) {
+    point[i] = x[i] * _invScales[i];
+  }
+  std::copy(outputs, outputs + _m, &_outputs[static_cast<size_t>(row) * _m]);
+}
+
+int LipschitzFilter::FindRejection(const double* x,
+                                   const double* bestObjective,
+                                   double* bound) const {
+  // A slope needs at least two neighbours
+  if (_numPoints < std::max(_numNeighbours, 2)) {
+    return -1;
+  }
+
+  // Keep the nearest neighbours sorted by squared distance, nearest first
+  typedef std::pair<double, int> Neighbour;
+  std::vector<Neighbour> nearest(_numNeighbours,
+      Neighbour(std::numeric_limits<double>::infinity(), -1));
+  for (int row = 0; row < _numPoints; ++row) {
+    const double* point = &_points[static_cast<size_t>(row) * _n];
+    const double worst = nearest.back().first;
+    double dist = 0;
+    for (int i = 0; i < _n && dist < worst; ++i) {
+      double d = x[i] * _invScales[i] - point[i];
+      dist += d * d;
+    }
+    if (dist >= worst) {
+      continue;
+    }
+
+    int j = _numNeighbours - 1;
+    while (j > 0 && nearest[j - 1].first > dist) {
+      nearest[j] = nearest[j - 1];
+      --j;
+    }
+    nearest[j] = Neighbour(dist, row);
+  }
+
+  const int k = _numNeighbours;
+  std::vector<double> distances(k);
+  std::vector<double> pairDistances(k * k, 0);
+  for (int a = 0; a < k; ++a) {
+    distances[a] = std::sqrt(nearest[a].first);
+    const double* pointA =
+        &_points[static_cast<size_t>(nearest[a].second) * _n];
+    for (int b = a + 1; b < k; ++b) {
+      const double* pointB =
+          &_points[static_cast<size_t>(nearest[b].second) * _n];
+      double dist = 0;
+      for (int i = 0; i < _n; ++i) {
+        double d = pointA[i] - pointB[i];
+        dist += d * d;
+      }
+      pairDistances[a * k + b] = std::sqrt(dist);
+    }
+  }
+
+  // Objectives can only be compared if there is one, and a feasible
+  // incumbent to compare with
+  const int first = (_numObjs == 1 && bestObjective != nullptr) ? 0 : _numObjs;
+  std::vector<double> values(k);
+  for (int output = first; output < _m; ++output) {
+    for (int a = 0; a < k; ++a) {
+      values[a] = _outputs[static_cast<size_t>(nearest[a].second) * _m +
+                           output];
+    }
+
+    double slope = 0;
+    for (int a = 0; a < k; ++a) {
+      for (int b = a + 1; b < k; ++b) {
+        if (pairDistances[a * k + b] > 0) {
+          slope = std::max(slope, std::fabs(values[a] - values[b]) /
+                                  pairDistances[a * k + b]);
+        }
+      }
+    }
+    slope *= _safetyFactor;
+
+    // Each neighbour bounds the output, the tightest bound is kept
+    double lowerBound = -std::numeric_limits<double>::infinity();
+    for (int a = 0; a < k; ++a) {
+      lowerBound = std::max(lowerBound, values[a] - slope * distances[a]);
+    }
+
+    double threshold = (output < _numObjs) ? *bestObjective : 0;
+    if (lowerBound > threshold) {
+      *bound = lowerBound;
+      return output;
+    }
+  }
+  return -1;
+}
+
+bool LipschitzFilter::ShouldSkip(const double* x,
+                                 const double* bestObjective) {
+  double bound;
+  int output = FindRejection(x, bestObjective, &bound);
+  if (output < 0) {
+    return false;
+  }
+
+  if (++_numPredicted % REJECTION_CHECK_INTERVAL == 0) {
+    ++_numChecked;
+    _checkPending = true;
+    _checkX.assign(x, x + _n);
+    _checkOutput = output;
+    _checkBound = bound;
+    return false;
+  }
+
+  ++_numSkipped;
+  if (output < _numObjs) {
+    ++_numSkippedObjective;
+  }
+  if (static_cast<int>(_rejections.size()) < MAX_RECORDED_REJECTIONS) {
+    LipschitzRejection rejection;
+    rejection.x.assign(x, x + _n);
+    rejection.output = output;
+    rejection.bound = bound;
+    _rejections.push_back(rejection);
+  }
+  return true;
+}
+
+}  // namespace OPENSOLVER
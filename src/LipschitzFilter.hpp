@@ -0,0 +1,111 @@
+// LipschitzFilter.hpp
+// Rejects points that the evaluations so far show can't improve the solve
+//
+// Around a new point, the rate of change of each output is estimated from
+// the largest slope between its nearest evaluated neighbours, with each
+// variable scaled by its range. Multiplied by a safety factor, this gives a
+// lower bound on every output at the point. A point is rejected without
+// recalculating if the bound on the objective is above the incumbent, or the
+// bound on any constraint is above zero, since all constraints are extreme
+// barriers. The estimate is only local, so every so often a rejection is
+// evaluated anyway to check it.
+
+#ifndef SRC_LIPSCHITZFILTER_H_
+#define SRC_LIPSCHITZFILTER_H_
+
+#include <vector>
+
+namespace OPENSOLVER {
+
+// A point the filter rejected, and why
+struct LipschitzRejection {
+  std::vector<double>  x;
+  int                  output;  // The output bounded, an objective if < numObjs
+  double               bound;   // Lower bound on the output at x
+};
+
+class LipschitzFilter {
+ public:
+  /**
+   * @param scales The range of each variable, used to scale distances
+   * @param numCons The number of outputs, including the objectives
+   * @param numObjs The number of objectives, which come first. Objectives
+   *                are only bounded if there is exactly one.
+   * @param numNeighbours The number of neighbours the slopes come from
+   * @param safetyFactor The multiple of the largest slope that is assumed
+   */
+  LipschitzFilter(const std::vector<double>& scales, int numCons, int numObjs,
+                  int numNeighbours, double safetyFactor);
+
+  /**
+   * Adds the result of an evaluation to the filter
+   *
+   * @param x The variable values of the point
+   * @param outputs The outputs of the point, NaN for Excel errors. Points
+   *                with errors are ignored.
+   */
+  void AddPoint(const double* x, const double* outputs);
+
+  /**
+   * Decides whether a point should be rejected as unable to improve
+   *
+   * @param x The variable values of the point
+   * @param bestObjective The objective of the feasible incumbent, or nullptr
+   *                      if there isn't one
+   * @return True if the point should not be evaluated
+   */
+  bool ShouldSkip(const double* x, const double* bestObjective);
+
+  // Number of points rejected, and how many of those on their objective
+  int GetNumSkipped() const { return _numSkipped; }
+  int GetNumSkippedObjective() const { return _numSkippedObjective; }
+
+  // Number of rejections evaluated anyway, and how many of those broke the
+  // bound that rejected them
+  int GetNumChecked() const { return _numChecked; }
+  int GetNumBoundsBroken() const { return _numBoundsBroken; }
+
+  // The first rejected points, in order
+  const std::vector<LipschitzRejection>& GetRejections() const {
+    return _rejections;
+  }
+
+ private:
+  /**
+   * Finds an output whose lower bound shows the point can't improve
+   *
+   * @param bound Set to the lower bound on that output
+   * @return The index of the output, or -1 if there is none
+   */
+  int FindRejection(const double* x, const double* bestObjective,
+                    double* bound) const;
+
+  int                  _n;
+  int                  _m;
+  int                  _numObjs;
+  int                  _numNeighbours;
+  double               _safetyFactor;
+  int                  _maxPoints;
+  std::vector<double>  _invScales;
+  std::vector<double>  _points;   // Scaled points, stored row by row
+  std::vector<double>  _outputs;  // Outputs of each point, row by row
+  int                  _numPoints;
+  int                  _next;     // Row to overwrite once the filter is full
+
+  // The rejection let through to be checked, until its outputs are added
+  bool                 _checkPending;
+  std::vector<double>  _checkX;
+  int                  _checkOutput;
+  double               _checkBound;
+
+  int                  _numPredicted;
+  int                  _numSkipped;
+  int                  _numSkippedObjective;
+  int                  _numChecked;
+  int                  _numBoundsBroken;
+  std::vector<LipschitzRejection> _rejections;
+};
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_LIPSCHITZFILTER_H_
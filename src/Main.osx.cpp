@@ -5,6 +5,15 @@
 
 #include <string>
 
+#include "ScenarioBatch.hpp"
+#include "SolveDaemon.hpp"
+
+int PrintUsage() {
+  fprintf(stderr, "Usage: OpenSolverNomad [-v | -nv | -batch]\n"
+                  "       OpenSolverNomad (-daemon | -solve | -stop) SOCKET\n");
+  return EXIT_FAILURE;
+}
+
 int main(int argc, const char * argv[]) {
   if (argc == 2) {
     const char* arg = argv[argc - 1];
@@ -14,9 +23,37 @@ int main(int argc, const char * argv[]) {
     } else if (strcmp(arg, "-nv") == 0) {
       printf("%s", NOMAD::VERSION.c_str());
       return EXIT_SUCCESS;
+    } else if (strcmp(arg, "-batch") == 0) {
+      return OPENSOLVER::RunScenarioBatch();
+    }
+  } else if (argc == 3) {
+    const char* mode = argv[1];
+    std::string socketPath = argv[2];
+    if (strcmp(mode, "-daemon") == 0) {
+      return OPENSOLVER::RunSolveDaemon(socketPath,
+                                        OPENSOLVER::RunNomadAndLoadResult);
+    } else if (strcmp(mode, "-solve") == 0) {
+      // Hand the solve to the daemon, or solve here if there isn't one. A
+      // daemon that died after taking the request may have changed the
+      // workbook already, so don't start another solve on top of it.
+      std::string reply;
+      switch (OPENSOLVER::SendDaemonRequest(socketPath, "SOLVE", &reply)) {
+        case OPENSOLVER::DAEMON_REPLIED:
+          return atoi(reply.c_str());
+        case OPENSOLVER::DAEMON_REPLY_LOST:
+          return OPENSOLVER::ERROR_OCCURED;
+        case OPENSOLVER::DAEMON_NOT_RUNNING:
+          break;
+      }
+    } else if (strcmp(mode, "-stop") == 0) {
+      std::string reply;
+      OPENSOLVER::SendDaemonRequest(socketPath, "QUIT", &reply);
+      return EXIT_SUCCESS;
+    } else {
+      return PrintUsage();
     }
-  } else if (argc > 2) {
-    //TODO error
+  } else if (argc > 3) {
+    return PrintUsage();
   }
   return OPENSOLVER::RunNomadAndLoadResult();
 }
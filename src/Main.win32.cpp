@@ -2,6 +2,7 @@
 // Functions that are exported in the Windows DLL
 
 #include "NomadInterface.hpp"
+#include "ScenarioBatch.hpp"
 
 // This needs to be below NomadInterface.hpp.
 // Including atlbase.h seems to break the NOMAD lib.
@@ -22,3 +23,9 @@ extern "C" BSTR _stdcall NomadDLLVersion() {
 extern "C" int _stdcall NomadMain(bool /*SolveRelaxation*/) {
   return OPENSOLVER::RunNomad();
 }
+
+// Solves every scenario defined in the workbook, see ScenarioBatch.hpp. Must
+// be called directly within VBA, like NomadMain.
+extern "C" int _stdcall NomadBatchMain() {
+  return OPENSOLVER::RunScenarioBatch();
+}
@@ -0,0 +1,21 @@
+// MemoryUsage.hpp
+// Reports the memory used by the solver process
+
+#ifndef SRC_MEMORYUSAGE_H_
+#define SRC_MEMORYUSAGE_H_
+
+#include <cstddef>
+
+namespace OPENSOLVER {
+
+/**
+ * Gets the peak resident memory of this process so far
+ *
+ * In the DLL on Windows this is the peak of the whole Excel process.
+ * @return The peak memory in bytes, or 0 if it is not available
+ */
+size_t GetPeakMemoryUsage();
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_MEMORYUSAGE_H_
@@ -2,14 +2,56 @@
 
 #include "NomadInterface.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <list>
+#include <memory>
+#include <set>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "AdaptiveReplication.hpp"
+#include "BinaryEnumeration.hpp"
+#include "ConstraintAggregator.hpp"
+#include "EvaluationBackend.hpp"
+#include "EvaluationHistory.hpp"
+#include "EvaluationOrder.hpp"
 #include "ExcelCallbacks.hpp"
+#include "HiddenConstraintModel.hpp"
+#include "InitialDesign.hpp"
+#include "LipschitzFilter.hpp"
+#include "MemoryUsage.hpp"
+#include "OptionTuner.hpp"
+#include "ParallelSpaceDecomposition.hpp"
+#include "SolverOptions.hpp"
+#include "StallMonitor.hpp"
 
 namespace OPENSOLVER {
 
+// Written next to the log file so that it persists between solves
+const char TUNING_HISTORY_FILE[] = "OpenSolverNomadTuning.txt";
+
+// How often the host thread checks for ESC while NOMAD works between
+// evaluations in a background solve
+const int BACKGROUND_ESCAPE_POLL_MS = 250;
+
+// Most violated constraints listed in the log when constraints are aggregated
+const int MAX_REPORTED_VIOLATIONS = 10;
+
+// Most points from the evaluation history kept in a solve summary
+const int MAX_SUMMARY_POINTS = 5;
+
+// Most variable values shown for each point rejected by the Lipschitz filter
+const int MAX_REPORTED_VALUES = 10;
+
 NOMAD::bb_input_type VarTypeToNomad(int varType) {
   switch (varType) {
     case CONTINUOUS:
@@ -32,25 +74,173 @@ class Excel_Evaluator : public NOMAD::Evaluator {
  private:
   int      _n;
   int      _m;
+  int      _numObjs;
   double * _px;
   double * _fx;
   NOMAD::Mads* _mads;
+  HiddenConstraintModel* _hiddenConstraints;
+  LipschitzFilter* _lipschitzFilter;
+  AdaptiveReplication* _replication;
+  EvaluationHistory* _history;
+  StallMonitor* _stallMonitor;
+  ConstraintAggregator* _aggregator;
+  const std::vector<int>* _precheckOutputs;
+  double * _precheckValues;
+  mutable int _numPrechecked;
+  mutable int _numRejected;
+  mutable int _numSurrogateEvals;
+  EvaluationDispatcher* _dispatcher;
+  std::atomic<bool> _abortRequested;
+  mutable bool _aborted;
+  mutable bool _stalled;
+
+  // The variables last written to the host, empty before the first write
+  mutable std::vector<double> _hostVars;
+
+  // Cost of the full evaluations, and of the variable changes between
+  // points in reordered blocks
+  mutable int _numFullEvals;
+  mutable double _fullEvalSeconds;
+  mutable int _numBlocks;
+  mutable int _numBlockSteps;
+  mutable int _numTourChanges;
+  mutable int _numListedChanges;
+
+  // Returns false if the user aborted, throws on any other error
+  bool CheckEvaluation(EXCEL_RC rc) const;
+
+  // Runs a host callback, on the host thread if NOMAD runs in the background
+  EXCEL_RC CallHost(const std::function<EXCEL_RC()>& call) const;
+
+  // Gives NOMAD the outputs in _fx, aggregating the constraints if needed
+  void SetOutputs(NOMAD::Eval_Point* x) const;
 
  public:
-  Excel_Evaluator(const NOMAD::Parameters &p, int n, int m) : Evaluator(p),
+  Excel_Evaluator(const NOMAD::Parameters &p, int n, int m, int numObjs) :
+        Evaluator(p),
         _n(n),
         _m(m),
+        _numObjs(numObjs),
         _px(new double[_n]),
-        _fx(new double[_m]) {}
+        _fx(new double[_m]),
+        _hiddenConstraints(nullptr),
+        _lipschitzFilter(nullptr),
+        _replication(nullptr),
+        _history(nullptr),
+        _stallMonitor(nullptr),
+        _aggregator(nullptr),
+        _precheckOutputs(nullptr),
+        _precheckValues(nullptr),
+        _numPrechecked(0),
+        _numRejected(0),
+        _numSurrogateEvals(0),
+        _dispatcher(nullptr),
+        _abortRequested(false),
+        _aborted(false),
+        _stalled(false),
+        _numFullEvals(0),
+        _fullEvalSeconds(0),
+        _numBlocks(0),
+        _numBlockSteps(0),
+        _numTourChanges(0),
+        _numListedChanges(0) {}
+
+  ~Excel_Evaluator(void) {
+    delete [] _px; delete [] _fx; delete [] _precheckValues; _mads = nullptr;
+  }
+
+  // Optional components, not owned by the evaluator
+  void SetHiddenConstraintModel(HiddenConstraintModel* hiddenConstraints) {
+    _hiddenConstraints = hiddenConstraints;
+  }
+  void SetLipschitzFilter(LipschitzFilter* lipschitzFilter) {
+    _lipschitzFilter = lipschitzFilter;
+  }
+  void SetReplication(AdaptiveReplication* replication) {
+    _replication = replication;
+  }
+  void SetHistory(EvaluationHistory* history) {
+    _history = history;
+  }
+  void SetStallMonitor(StallMonitor* stallMonitor) {
+    _stallMonitor = stallMonitor;
+  }
+  void SetAggregator(ConstraintAggregator* aggregator) {
+    _aggregator = aggregator;
+  }
+  void SetPrecheck(const std::vector<int>* precheckOutputs) {
+    _precheckOutputs = precheckOutputs;
+    delete [] _precheckValues;
+    _precheckValues = new double[precheckOutputs->size()];
+  }
 
-  ~Excel_Evaluator(void) { delete [] _px; delete [] _fx; _mads = nullptr; }
+  void SetDispatcher(EvaluationDispatcher* dispatcher) {
+    _dispatcher = dispatcher;
+  }
+
+  // Asks the solve to stop at its next host call. Safe from any thread, as
+  // only the solver thread may touch NOMAD's quit flag.
+  void RequestAbort() { _abortRequested = true; }
+
+  int GetNumPrechecked() const { return _numPrechecked; }
+  int GetNumRejected() const { return _numRejected; }
+  int GetNumSurrogateEvals() const { return _numSurrogateEvals; }
+  bool IsStalled() const { return _stalled; }
+  int GetNumFullEvals() const { return _numFullEvals; }
+  double GetFullEvalSeconds() const { return _fullEvalSeconds; }
+  int GetNumBlocks() const { return _numBlocks; }
+  int GetNumBlockSteps() const { return _numBlockSteps; }
+  int GetNumTourChanges() const { return _numTourChanges; }
+  int GetNumListedChanges() const { return _numListedChanges; }
 
   // eval_x:
   bool eval_x(NOMAD::Eval_Point& x,
               const NOMAD::Double& h_max,
               bool& count_eval) const override;
+
+  // Evaluates a block of points (BB_MAX_BLOCK_SIZE > 1) in an order that
+  // changes few variables between recalculations
+  bool eval_x(std::list<NOMAD::Eval_Point*>& list_x,
+              const NOMAD::Double& h_max,
+              std::list<bool>& count_list_eval) const override;
 };
 
+bool Excel_Evaluator::CheckEvaluation(EXCEL_RC rc) const {
+  if (rc != SUCCESS) {
+    if (GetErrorCode(rc) == ESC_ABORT) {
+      // Rather than just throw an escape exception, we want to simulate ctrl-c
+      mads->force_quit(0);
+      _aborted = true;
+      return false;
+    } else {
+      // Guaranteed to throw since rc != SUCCESS
+      ValidateReturnCode(rc);
+    }
+  }
+  return true;
+}
+
+EXCEL_RC Excel_Evaluator::CallHost(
+    const std::function<EXCEL_RC()>& call) const {
+  if (_abortRequested) {
+    return ESC_ABORT;
+  }
+  return (_dispatcher == nullptr) ? call() : _dispatcher->Call(call);
+}
+
+void Excel_Evaluator::SetOutputs(NOMAD::Eval_Point* x) const {
+  // Only give NOMAD the objectives and a value for each constraint group
+  int numOutputs = _m;
+  if (_aggregator != nullptr) {
+    _aggregator->Aggregate(_fx);
+    numOutputs = _aggregator->GetNumOutputs();
+  }
+
+  for (int i = 0; i < numOutputs; ++i) {
+    x->set_bb_output(i, _fx[i]);
+  }
+}
+
 // eval_x:
 bool Excel_Evaluator::eval_x(NOMAD::Eval_Point& x,
                              const NOMAD::Double& /*h_max*/,
@@ -58,6 +248,14 @@ bool Excel_Evaluator::eval_x(NOMAD::Eval_Point& x,
   for (int i = 0; i < _n; ++i) {
     _px[i] = x[i].value();
   }
+  const bool surrogate = (x.get_eval_type() == NOMAD::SGTE);
+
+  // Don't spend a recalculation on a point we expect to give an Excel error
+  if (!surrogate && _hiddenConstraints != nullptr &&
+      _hiddenConstraints->ShouldSkip(_px)) {
+    count_eval = false;
+    return false;
+  }
 
   // Get current solution for status updating
   bool feasibility = true;
@@ -77,63 +275,277 @@ bool Excel_Evaluator::eval_x(NOMAD::Eval_Point& x,
     feasibility = false;
   }
 
+  double bestValue;
   double* bestSol = nullptr;
   if (bestPoint != nullptr) {
-    double bestValue = bestPoint->get_f().value();
+    bestValue = bestPoint->get_f().value();
     bestSol = &bestValue;
   }
 
-  EXCEL_RC rc = EvaluateX(_px, _n, _m, bestSol, feasibility, _fx);
-  if (rc != SUCCESS) {
-    if (GetErrorCode(rc) == ESC_ABORT) {
-      // Rather than just throw an escape exception, we want to simulate ctrl-c
-      mads->force_quit(0);
+  // Low-fidelity values only screen and order candidates, so they skip the
+  // checks and records that are kept for full evaluations
+  if (surrogate) {
+    _hostVars.assign(_px, _px + _n);
+    if (!CheckEvaluation(CallHost([&] {
+          return SurrogateEvaluateX(_px, _n, _m, bestSol, feasibility, _fx);
+        }))) {
+      return false;
+    }
+    ++_numSurrogateEvals;
+    SetOutputs(&x);
+    count_eval = true;
+    return true;
+  }
+
+  // Skip points that the evaluations around them show can't improve
+  if (_lipschitzFilter != nullptr &&
+      _lipschitzFilter->ShouldSkip(_px, feasibility ? bestSol : nullptr)) {
+    count_eval = false;
+    return false;
+  }
+
+  std::chrono::steady_clock::time_point evalStart =
+      std::chrono::steady_clock::now();
+  _hostVars.assign(_px, _px + _n);
+  if (_precheckOutputs != nullptr) {
+    // Recalculate only the cheap outputs first. A point that violates one of
+    // them is infeasible whatever the rest of the model gives.
+    const int numPrecheck = static_cast<int>(_precheckOutputs->size());
+    if (!CheckEvaluation(CallHost([&] {
+          return PrecheckX(_px, _n, bestSol, feasibility, numPrecheck,
+                           _precheckValues);
+        }))) {
+      return false;
+    }
+    ++_numPrechecked;
+    // Rejected points never got a full recalculation, so like the other
+    // skipped points they don't count towards MAX_BB_EVAL
+    for (int i = 0; i < numPrecheck; ++i) {
+      if (!(_precheckValues[i] <= 0)) {
+        ++_numRejected;
+        count_eval = false;
+        return false;
+      }
+    }
+    // The variables are already in place
+    if (!CheckEvaluation(CallHost([&] { return ReevaluateX(_m, _fx); }))) {
       return false;
-    } else {
-      // Guaranteed to throw since rc != SUCCESS
-      ValidateReturnCode(rc);
     }
+  } else if (!CheckEvaluation(CallHost([&] {
+               return EvaluateX(_px, _n, _m, bestSol, feasibility, _fx);
+             }))) {
+    return false;
   }
-  for (int i = 0; i < _m; ++i) {
-    x.set_bb_output(i, _fx[i]);
+  ++_numFullEvals;
+  _fullEvalSeconds += std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - evalStart).count();
+
+  // Average repeated reads of noisy points that could beat the incumbent
+  if (_replication != nullptr) {
+    _replication->Begin(_fx);
+    while (_replication->NeedsMore(bestSol)) {
+      if (!CheckEvaluation(CallHost([&] { return ReevaluateX(_m, _fx); }))) {
+        return false;
+      }
+      _replication->Add(_fx);
+    }
+    _replication->Finish(_fx);
   }
+
+  if (_hiddenConstraints != nullptr) {
+    bool failed = false;
+    for (int i = 0; i < _m; ++i) {
+      failed = failed || std::isnan(_fx[i]);
+    }
+    _hiddenConstraints->AddPoint(_px, failed);
+  }
+
+  if (_history != nullptr) {
+    _history->Add(_px, _fx);
+  }
+
+  if (_lipschitzFilter != nullptr) {
+    _lipschitzFilter->AddPoint(_px, _fx);
+  }
+
+  // Stop cleanly, as for ESC, once the incumbent has stopped improving
+  if (_stallMonitor != nullptr && !_stalled) {
+    double step = 0;
+    if (bestPoint != nullptr) {
+      for (int i = 0; i < _n; ++i) {
+        step = std::max(step, _stallMonitor->ScaleStep(
+            i, std::fabs(_px[i] - (*bestPoint)[i].value())));
+      }
+    }
+    if (_stallMonitor->Update(feasibility ? bestSol : nullptr, step)) {
+      _stalled = true;
+      mads->force_quit(0);
+    }
+  }
+
+  SetOutputs(&x);
   count_eval = true;
   return true;
 }
 
+bool Excel_Evaluator::eval_x(std::list<NOMAD::Eval_Point*>& list_x,
+                             const NOMAD::Double& h_max,
+                             std::list<bool>& count_list_eval) const {
+  std::vector<NOMAD::Eval_Point*> block(list_x.begin(), list_x.end());
+  const int numPoints = static_cast<int>(block.size());
+  std::vector<std::vector<double> > values(numPoints, vector<double>(_n));
+  std::vector<const double*> points(numPoints);
+  for (int k = 0; k < numPoints; ++k) {
+    for (int i = 0; i < _n; ++i) {
+      values[k][i] = (*block[k])[i].value();
+    }
+    points[k] = values[k].data();
+  }
+
+  // Start the tour from the point the host's cells already hold
+  const double* start = _hostVars.empty() ? nullptr : _hostVars.data();
+  std::vector<int> order = OrderForLocality(points, _n, start);
+  if (numPoints > 1) {
+    std::vector<int> listed(numPoints);
+    for (int k = 0; k < numPoints; ++k) {
+      listed[k] = k;
+    }
+    ++_numBlocks;
+    _numBlockSteps += (start == nullptr) ? numPoints - 1 : numPoints;
+    _numTourChanges += CountTourChanges(points, order, _n, start);
+    _numListedChanges += CountTourChanges(points, listed, _n, start);
+  }
+
+  // NOMAD only checks for success once the whole block is back, so stop the
+  // block ourselves at the first full evaluation that beats the incumbent.
+  // Only a single objective can be compared this way.
+  const bool opportunistic = _p.get_opportunistic_eval() && _numObjs == 1;
+  bool hasBest = false;
+  double bestF = 0;
+  const NOMAD::Eval_Point *bestPoint = mads->get_best_feasible();
+  if (bestPoint != nullptr) {
+    hasBest = true;
+    bestF = bestPoint->get_f().value();
+  }
+
+  // Points skipped after a success are rejected rather than failed, so
+  // NOMAD may generate and evaluate them again later
+  std::vector<bool> counted(numPoints, false);
+  for (int k = 0; k < numPoints; ++k) {
+    block[k]->set_eval_status(NOMAD::EVAL_USER_REJECT);
+  }
+
+  bool stop = false;
+  for (int k = 0; k < numPoints && !stop; ++k) {
+    NOMAD::Eval_Point* x = block[order[k]];
+    bool countEval = false;
+    bool ok = eval_x(*x, h_max, countEval);
+    counted[order[k]] = countEval;
+    x->set_eval_status(ok ? NOMAD::EVAL_OK : NOMAD::EVAL_FAIL);
+    if (_aborted) {
+      count_list_eval.assign(counted.begin(), counted.end());
+      return false;
+    }
+    if (_stalled) {
+      break;
+    }
+
+    if (ok && opportunistic && x->get_eval_type() == NOMAD::TRUTH) {
+      // All constraints are extreme barriers, so any positive output means
+      // the point is infeasible
+      const NOMAD::Point& outputs = x->get_bb_outputs();
+      bool feasible = true;
+      for (int i = _numObjs; i < outputs.size(); ++i) {
+        feasible = feasible && outputs[i].value() <= 0;
+      }
+      double f = outputs[0].value();
+      if (feasible && (!hasBest || f < bestF)) {
+        stop = true;
+      }
+    }
+  }
+
+  count_list_eval.assign(counted.begin(), counted.end());
+  return true;
+}
+
+// Lists the options that are set but ignored when MADS doesn't run. PSD-MADS
+// ignores the pre-check outputs as well.
+vector<string> GetIgnoredOptions(const SolverOptions& options,
+                                 const ProblemDescriptor& problem,
+                                 const vector<vector<double> >& seeds,
+                                 bool ignoresPrecheck) {
+  vector<string> ignored = GetOptionsIgnoredWithoutMads(options);
+  if (problem.hasSurrogate && options.useSurrogate) {
+    ignored.push_back("USE_SURROGATE");
+  }
+  if (!problem.useWarmstart && options.initialDesign != MIDPOINT_DESIGN) {
+    ignored.push_back("INITIAL_DESIGN");
+  }
+  if (ignoresPrecheck && !problem.precheckOutputs.empty()) {
+    ignored.push_back("pre-check outputs");
+  }
+  if (!seeds.empty()) {
+    ignored.push_back("seeds from related solves");
+  }
+  return ignored;
+}
+
+void LogIgnoredOptions(const string& engine, const vector<string>& ignored,
+                       const NOMAD::Display& out) {
+  if (!ignored.empty()) {
+    out << engine << " ignores:";
+    for (size_t i = 0; i < ignored.size(); ++i) {
+      out << (i == 0 ? " " : ", ") << ignored[i];
+    }
+    out << endl;
+  }
+}
+
 NomadResult RunNomad() {
-  std::string logFilePath;
+  return RunNomadFromSeeds(vector<vector<double> >(), nullptr, false);
+}
+
+NomadResult RunNomadFromSeeds(const vector<vector<double> >& seeds,
+                              SolveSummary* summary, bool appendLog) {
+  if (summary != nullptr) {
+    *summary = SolveSummary();
+  }
 
-  // Get a temp path to write parameters etc to
-  if (GetLogFilePath(&logFilePath) != SUCCESS) {
+  // Get the whole problem from Excel, including a temp path to write
+  // parameters etc to
+  ProblemDescriptor problem;
+  int numHostCalls = 0;
+  std::chrono::steady_clock::time_point loadStart =
+      std::chrono::steady_clock::now();
+  EXCEL_RC loadRc = LoadProblem(&problem, &numHostCalls);
+  double loadSeconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - loadStart).count();
+  if (loadRc != SUCCESS && problem.logPath.empty()) {
     return LOG_FILE_ERROR;
   }
+  const std::string& logFilePath = problem.logPath;
 
-  ofstream logFile(logFilePath.c_str(), ios::out);
+  ofstream logFile(logFilePath.c_str(), appendLog ? ios::app : ios::out);
   NOMAD::Display out(logFile);
   out.precision(NOMAD::DISPLAY_PRECISION_STD);
 
   try {
     NOMAD::begin(0, nullptr);
 
-    // Variable information
-    int numVars;
-    ValidateReturnCode(GetNumVariables(&numVars));
+    ValidateReturnCode(loadRc);
+    out << "Loaded problem from Excel in " << loadSeconds << " seconds using "
+        << numHostCalls << " host calls" << endl;
 
+    // Variable information
+    const int numVars = problem.numVars;
     if (numVars < 1) {
       throw std::runtime_error("No variables returned");
     }
 
-    double * const lowerBounds =   new double[numVars];
-    double * const upperBounds =   new double[numVars];
-    double * const startingPoint = new double[numVars];
-    int * const varTypes =         new int[numVars];
-
-    ValidateReturnCode(GetVariableData(numVars, lowerBounds, upperBounds,
-                                       startingPoint, varTypes));
     for (int i = 0; i < numVars; ++i) {
-      if (upperBounds[i] >= 1e10) {
-        upperBounds[i] = NOMAD::INF;
+      if (problem.upperBounds[i] >= 1e10) {
+        problem.upperBounds[i] = NOMAD::INF;
       }
     }
 
@@ -141,22 +553,27 @@ NomadResult RunNomad() {
     NOMAD::Point ub(numVars);
     NOMAD::Point lb(numVars);
     vector<NOMAD::bb_input_type> bbit(numVars);
+    vector<double> varRanges(numVars);
     for (int i = 0; i < numVars; i++) {
-      ub[i] = upperBounds[i];
-      lb[i] = lowerBounds[i];
-      x0[i] = startingPoint[i];
-      bbit[i] = VarTypeToNomad(varTypes[i]);
+      const double lower = problem.lowerBounds[i];
+      const double upper = problem.upperBounds[i];
+      ub[i] = upper;
+      lb[i] = lower;
+      x0[i] = problem.startingX[i];
+      bbit[i] = VarTypeToNomad(problem.varTypes[i]);
+      // Unbounded variables get a zero range, meaning no scaling
+      varRanges[i] = (upper < NOMAD::INF && lower > -1e10) ? upper - lower : 0;
     }
 
-    delete[] lowerBounds;
-    delete[] upperBounds;
-    delete[] startingPoint;
-    delete[] varTypes;
-
     // Constraint/Objective info
-    int numCons;
-    int numObjs;
-    ValidateReturnCode(GetNumConstraints(&numCons, &numObjs));
+    const int numCons = problem.numCons;
+    const int numObjs = problem.numObjs;
+    for (size_t i = 0; i < problem.precheckOutputs.size(); ++i) {
+      if (problem.precheckOutputs[i] < numObjs ||
+          problem.precheckOutputs[i] >= numCons) {
+        throw std::runtime_error("invalid pre-check outputs");
+      }
+    }
 
     vector<NOMAD::bb_output_type> bbot(numCons);
     for (int i = 0; i < numObjs; i++) {
@@ -167,18 +584,29 @@ NomadResult RunNomad() {
     }
 
     // User options
-    string *paramStrings;
-    int numStrings;
-    ValidateReturnCode(GetOptionData(&paramStrings, &numStrings));
-
     NOMAD::Parameter_Entries entries;
     NOMAD::Parameter_Entry *pe;
+    std::set<string> userOptionNames;  // Both NOMAD's and our own
+    SolverOptions options;
     string err;
     bool invalid = false;
-    for (int i = 0; i < numStrings; ++i) {
-      pe = new NOMAD::Parameter_Entry(*(paramStrings + i));
+    for (size_t i = 0; i < problem.options.size(); ++i) {
+      pe = new NOMAD::Parameter_Entry(problem.options[i]);
       if (pe->is_ok()) {
-        entries.insert(pe);  // pe will be deleted by ~Parameter_Entries()
+        // Our own options are read here and never reach NOMAD
+        bool isSolverOption;
+        try {
+          isSolverOption = ReadSolverOption(*pe, &options);
+        } catch (...) {
+          delete pe;
+          throw;
+        }
+        userOptionNames.insert(GetOptionName(*pe));
+        if (isSolverOption) {
+          delete pe;
+        } else {
+          entries.insert(pe);  // pe will be deleted by ~Parameter_Entries()
+        }
       } else {
         if ((pe->get_name() != "" && pe->get_nb_values() == 0) ||
             pe->get_name() == "STATS_FILE") {
@@ -191,26 +619,135 @@ NomadResult RunNomad() {
         }
       }
     }
-    delete[] paramStrings;
 
-    // Only set the warmstart if we are supposed to
-    bool useWarmstart;
-    ValidateReturnCode(GetUseWarmstart(&useWarmstart));
+    // Only set the warmstart if we are supposed to. Otherwise start from a
+    // design spread over the bounds, which NOMAD evaluates in full before
+    // continuing from the best point. PSD-MADS takes a single start.
+    const bool useWarmstart = problem.useWarmstart;
+    vector<NOMAD::Point> starts(1, x0);
     if (!useWarmstart) {
-      for (int i = 0; i < numVars; ++i) {
-        x0[i] = (lb[i] + ub[i]) / 2;
+      InitialDesignType designType = (options.psdWorkers > 0)
+                                     ? MIDPOINT_DESIGN : options.initialDesign;
+      int designSize = (options.initialDesignSize > 0)
+                       ? options.initialDesignSize : numVars + 1;
+      vector<vector<double> > design = CreateInitialDesign(
+          designType, designSize, problem.lowerBounds, problem.upperBounds,
+          problem.varTypes);
+      starts.assign(design.size(), NOMAD::Point(numVars));
+      for (size_t k = 0; k < design.size(); ++k) {
+        for (int i = 0; i < numVars; ++i) {
+          starts[k][i] = design[k][i];
+        }
       }
+      x0 = starts[0];
+    }
+    const size_t designSize = useWarmstart ? 0 : starts.size();
+
+    // Points from related solves, such as earlier scenarios of a batch, are
+    // started from as well once moved inside the bounds
+    size_t numSeeded = 0;
+    if (!seeds.empty() && options.psdWorkers == 0) {
+      for (size_t k = 0; k < seeds.size(); ++k) {
+        if (static_cast<int>(seeds[k].size()) != numVars) {
+          continue;
+        }
+        NOMAD::Point start(numVars);
+        for (int i = 0; i < numVars; ++i) {
+          double value = seeds[k][i];
+          if (problem.varTypes[i] != CONTINUOUS) {
+            value = std::round(value);
+          }
+          start[i] = std::max(problem.lowerBounds[i],
+                              std::min(value, problem.upperBounds[i]));
+        }
+        starts.push_back(start);
+        ++numSeeded;
+      }
+    }
+
+    // Keep a compact history of the full outputs. PSD-MADS subproblems are
+    // short-lived, so their caches don't need it.
+    std::unique_ptr<EvaluationHistory> history;
+    if (options.historyStore && options.psdWorkers == 0) {
+      const size_t bytesPerMb = 1024 * 1024;
+      history.reset(new EvaluationHistory(
+          numVars, numCons, numObjs, options.historyMemoryMb * bytesPerMb,
+          options.historyFloatOutputs));
+    }
+
+    // Give NOMAD one output per group of constraints. The store only keeps
+    // what NOMAD needs, which is the largest constraint. PSD-MADS workers
+    // read the outputs themselves, so they get all of them.
+    ConstraintAggregation aggregation = options.constraintAggregation;
+    int numGroups = options.constraintGroups;
+    if (history && aggregation == NO_AGGREGATION) {
+      aggregation = MAX_AGGREGATION;
+      numGroups = 1;
+    }
+    std::unique_ptr<ConstraintAggregator> aggregator;
+    if (aggregation != NO_AGGREGATION && numCons > numObjs &&
+        options.psdWorkers == 0) {
+      aggregator.reset(new ConstraintAggregator(numCons, numObjs, aggregation,
+                                                numGroups));
+      // The constraints are all EB, so any of them can stand for the group
+      bbot.resize(aggregator->GetNumOutputs());
+    }
+
+    // Fill in options the user didn't give based on the model's features.
+    // Anything the user gave is left as it is.
+    std::unique_ptr<OptionTuner> tuner;
+    if (options.autoTune) {
+      size_t pathEnd = logFilePath.find_last_of("/\\");
+      string historyPath = (pathEnd == string::npos)
+                           ? TUNING_HISTORY_FILE
+                           : logFilePath.substr(0, pathEnd + 1) +
+                             TUNING_HISTORY_FILE;
+      tuner.reset(new OptionTuner(problem.varTypes, problem.lowerBounds,
+                                  problem.upperBounds, numCons, numObjs,
+                                  historyPath));
+      out << "Auto-tuning model " << tuner->GetFingerprint() << " ("
+          << tuner->GetNumEarlierSolves() << " earlier solves)" << endl;
+      vector<string> tuned = tuner->ChooseOptions(options.evaluationBlockSize,
+                                                  useWarmstart);
+      for (size_t i = 0; i < tuned.size(); ++i) {
+        pe = new NOMAD::Parameter_Entry(tuned[i]);
+        if (userOptionNames.count(GetOptionName(*pe)) > 0) {
+          out << "  kept user value of " << pe->get_name() << endl;
+          delete pe;
+        } else {
+          out << "  chose " << tuned[i] << endl;
+          entries.insert(pe);
+        }
+      }
+    } else if (userOptionNames.count("EVALUATION_BLOCK_SIZE") > 0 &&
+               userOptionNames.count("BB_MAX_BLOCK_SIZE") == 0 &&
+               options.evaluationBlockSize > 1) {
+      // Without the tuner, blocks are only used when asked for
+      string blockSize = "BB_MAX_BLOCK_SIZE " +
+                         std::to_string(options.evaluationBlockSize);
+      out << "Evaluating blocks with " << blockSize << endl;
+      entries.insert(new NOMAD::Parameter_Entry(blockSize));
     }
 
     // Set all parameters
     NOMAD::Parameters p(out);
     p.set_DIMENSION(numVars);
-    p.set_X0(x0);
+    for (size_t k = 0; k < starts.size(); ++k) {
+      p.set_X0(starts[k]);
+    }
     p.set_UPPER_BOUND(ub);
     p.set_LOWER_BOUND(lb);
     p.set_BB_INPUT_TYPE(bbit);
     p.set_BB_OUTPUT_TYPE(bbot);
     p.set_DISPLAY_STATS("bbe ( sol ) obj");
+    // Let NOMAD screen and order candidates with the host's low-fidelity
+    // mode. PSD-MADS subproblems only make full evaluations.
+    const bool useSurrogate = problem.hasSurrogate && options.useSurrogate &&
+                              options.psdWorkers == 0;
+    if (useSurrogate) {
+      p.set_HAS_SGTE(true);
+      p.set_SGTE_EVAL_SORT(true);
+    }
     p.read(entries);
 
     p.check();
@@ -218,45 +755,401 @@ NomadResult RunNomad() {
     // Display parameters:
     out << p << endl;
 
-    // Run NOMAD
-    Excel_Evaluator ev(p, numVars, numCons);
-    mads = new NOMAD::Mads (p, &ev);
-    NOMAD::stop_type stopflag = mads->run();
+    // Learn where Excel errors occur so we can avoid recalculating there
+    std::unique_ptr<HiddenConstraintModel> hiddenConstraints;
+    if (options.hiddenConstraintModel) {
+      hiddenConstraints.reset(new HiddenConstraintModel(
+          varRanges, options.hiddenConstraintNeighbours));
+    }
+
+    // Bound the outputs of new points from the slopes between evaluations
+    std::unique_ptr<LipschitzFilter> lipschitzFilter;
+    if (options.lipschitzFilter) {
+      lipschitzFilter.reset(new LipschitzFilter(
+          varRanges, numCons, numObjs, options.lipschitzNeighbours,
+          options.lipschitzSafety));
+    }
+
+    // Watch for a solve that has stopped improving
+    std::unique_ptr<StallMonitor> stallMonitor;
+    if (options.stallWindow > 0) {
+      stallMonitor.reset(new StallMonitor(varRanges, options.stallWindow,
+                                          options.stallTolerance));
+    }
+
+    // Average repeated reads for models with noisy outputs. The incumbent
+    // reported at the end is then the averaged one.
+    std::unique_ptr<AdaptiveReplication> replication;
+    if (options.noisyReplication) {
+      replication.reset(new AdaptiveReplication(
+          numCons, numObjs, options.noisyMaxReplicates,
+          options.noisyReplicationBudget, options.noisyTolerance));
+    }
+
+    bool feasibility = true;
+    bool hasSolution = false;
+    vector<double> finalVars(numVars);
+    double bestPoint = 0;
+    NOMAD::stop_type stopflag;
+    int numPrechecked = 0;
+    int numSurrogateEvals = 0;
+    int numRejected = 0;
+    int numFullEvals = 0;
+    double fullEvalSeconds = 0;
+    int numBlocks = 0;
+    int numBlockSteps = 0;
+    int numTourChanges = 0;
+    int numListedChanges = 0;
+    bool stoppedTime;
+    bool stoppedIter;
+    bool stalled = false;
+    int numEvals = 0;
+    std::chrono::steady_clock::time_point solveStart =
+        std::chrono::steady_clock::now();
+
+    // Small all-binary models are cheaper to enumerate than to search, as
+    // long as the whole space fits in the evaluation budget. Without a
+    // budget, MADS is left to decide when to stop.
+    int numFree = CountEnumerationVariables(problem.lowerBounds,
+                                            problem.upperBounds,
+                                            problem.varTypes);
+    bool enumerate = (numFree >= 0 &&
+                      numFree <= options.enumerationMaxVariables &&
+                      numObjs <= 1 && p.get_max_bb_eval() > 0 &&
+                      (1 << numFree) <= p.get_max_bb_eval());
+
+    if (enumerate) {
+      // The enumeration does use the pre-check outputs
+      LogIgnoredOptions("Enumeration", GetIgnoredOptions(options, problem,
+                                                         seeds, false), out);
+      EnumerationSettings settings;
+      settings.numWorkers = options.enumerationWorkers;
+      settings.precheckOutputs = problem.precheckOutputs.empty()
+                                 ? nullptr : &problem.precheckOutputs;
+      EnumerationResult result = RunBinaryEnumeration(
+          problem.lowerBounds, problem.upperBounds, numCons, numObjs,
+          p.get_max_time(), settings, out);
+      stopflag = result.stopReason;
+      stoppedTime = (stopflag == NOMAD::MAX_TIME_REACHED);
+      stoppedIter = false;
+      numEvals = result.bbEval;
+      hasSolution = result.hasSolution;
+      feasibility = result.feasible;
+      if (hasSolution) {
+        finalVars = result.x;
+        bestPoint = result.f;
+      }
+    } else if (options.psdWorkers > 0) {
+      LogIgnoredOptions("PSD-MADS", GetIgnoredOptions(options, problem, seeds,
+                                                      true), out);
+      // Run PSD-MADS over worker threads, serving their evaluations here
+      PsdSettings settings;
+      settings.numWorkers = options.psdWorkers;
+      settings.subsetSize = options.psdSubsetSize;
+      settings.subproblemEvals = options.psdSubproblemEvals;
+      PsdResult result = RunParallelSpaceDecomposition(p, x0, numObjs,
+                                                       settings, out);
+      stopflag = result.stopReason;
+      stoppedTime = (stopflag == NOMAD::MAX_TIME_REACHED);
+      stoppedIter = (stopflag == NOMAD::MAX_BB_EVAL_REACHED);
+      numEvals = result.bbEval;
+      hasSolution = result.hasSolution;
+      feasibility = result.feasible;
+      if (hasSolution) {
+        finalVars = result.x;
+        bestPoint = result.f;
+      }
+    } else {
+      // Only logged now the engine is known, as the others ignore them
+      if (aggregator) {
+        out << "Aggregating " << numCons - numObjs << " constraints into "
+            << aggregator->GetNumGroups() << " groups" << endl;
+      }
+      if (useSurrogate) {
+        out << "Using the model's low-fidelity mode as a surrogate" << endl;
+      }
+      if (designSize > 0) {
+        out << "Initial design of " << designSize << " points" << endl;
+      }
+      if (numSeeded > 0) {
+        out << "Seeded with " << numSeeded << " points from related solves"
+            << endl;
+      }
+
+      // Run NOMAD
+      Excel_Evaluator ev(p, numVars, numCons, numObjs);
+      ev.SetHiddenConstraintModel(hiddenConstraints.get());
+      ev.SetLipschitzFilter(lipschitzFilter.get());
+      ev.SetStallMonitor(stallMonitor.get());
+      ev.SetReplication(replication.get());
+      ev.SetHistory(history.get());
+      ev.SetAggregator(aggregator.get());
+      // Constraints the host can compute cheaply are checked before the full
+      // recalculation
+      if (!problem.precheckOutputs.empty()) {
+        ev.SetPrecheck(&problem.precheckOutputs);
+      }
+      mads = new NOMAD::Mads (p, &ev);
+      if (options.backgroundSolve) {
+        // Run NOMAD on its own thread so that the host thread can watch for
+        // ESC while NOMAD works between evaluations. Host calls still block
+        // the solver thread until they finish.
+        HostBackend host;
+        EvaluationDispatcher dispatcher(&host);
+        ev.SetDispatcher(&dispatcher);
+        std::exception_ptr solveError;
+        std::thread solver([&] {
+          try {
+            stopflag = mads->run();
+          } catch (...) {
+            solveError = std::current_exception();
+          }
+          dispatcher.Stop();
+        });
+        bool aborted = false;
+        dispatcher.Serve(BACKGROUND_ESCAPE_POLL_MS, [&aborted, &ev] {
+          if (!aborted &&
+              GetErrorCode(CheckForEscapeKeypress(true)) == ESC_ABORT) {
+            aborted = true;
+            ev.RequestAbort();
+          }
+        });
+        solver.join();
+        if (solveError) {
+          std::rethrow_exception(solveError);
+        }
+      } else {
+        stopflag = mads->run();
+      }
+
+      // Obtain Solution
+      const NOMAD::Eval_Point *bestSol = mads->get_best_feasible();
+      if (bestSol == nullptr) {
+        bestSol = mads->get_best_infeasible();
+        // Manually mark infeasibility (there isn't an infeasible flag)
+        feasibility = false;
+      }
+      if (bestSol != nullptr) {
+        hasSolution = true;
+        for (int i = 0; i < numVars; ++i) {
+          finalVars[i] = (*bestSol)[i].value();
+        }
+        bestPoint = bestSol->get_f().value();
+      }
+      stoppedTime = (mads->get_stats().get_real_time() == p.get_max_time());
+      stoppedIter = (mads->get_stats().get_bb_eval() == p.get_max_bb_eval());
+      numEvals = mads->get_stats().get_bb_eval();
+      numPrechecked = ev.GetNumPrechecked();
+      numRejected = ev.GetNumRejected();
+      numSurrogateEvals = ev.GetNumSurrogateEvals();
+      numFullEvals = ev.GetNumFullEvals();
+      fullEvalSeconds = ev.GetFullEvalSeconds();
+      numBlocks = ev.GetNumBlocks();
+      numBlockSteps = ev.GetNumBlockSteps();
+      numTourChanges = ev.GetNumTourChanges();
+      numListedChanges = ev.GetNumListedChanges();
+      stalled = ev.IsStalled();
+
+      // Free Memory
+      delete mads;
+      mads = nullptr;
+    }
+    double solveSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - solveStart).count();
     NOMAD::Slave::stop_slaves(out);
     NOMAD::end();
 
-    bool feasibility = true;
-    // Obtain Solution
-    const NOMAD::Eval_Point *bestSol = mads->get_best_feasible();
-    if (bestSol == nullptr) {
-      bestSol = mads->get_best_infeasible();
-      // Manually mark infeasibility (there isn't an infeasible flag)
+    // Only the evaluator's own timing is learnt from, as the solve time
+    // includes NOMAD's work. On a cold start x0 is just the first design
+    // point, so there is no step from the user's values to learn.
+    if (tuner && hasSolution && numFullEvals > 0) {
+      vector<double> startValues;
+      if (useWarmstart) {
+        startValues.resize(numVars);
+        for (int i = 0; i < numVars; ++i) {
+          startValues[i] = x0[i].value();
+        }
+      }
+      tuner->RecordSolve(fullEvalSeconds / numFullEvals, startValues,
+                         finalVars);
+    }
+
+    if (hasSolution) {
+      UpdateVars(finalVars.data(), numVars, &bestPoint, feasibility);
+    } else {
       feasibility = false;
     }
-    if (bestSol != nullptr) {
-      double * const finalVars = new double[numVars];
-      for (int i = 0; i < numVars; ++i) {
-        finalVars[i] = (*bestSol)[i].value();
+
+    // NOMAD only saw the groups, so report which constraints are violated at
+    // the solution. The history store already has them. Without it, that
+    // takes another recalculation, which is only made on request.
+    if (aggregator && hasSolution) {
+      vector<double> finalOutputs;
+      vector<double> incumbentVars;
+      bool hasOutputs = false;
+      if (history && history->GetIncumbent(&incumbentVars, &finalOutputs) &&
+          incumbentVars == finalVars) {
+        hasOutputs = true;
+      } else if (options.reportViolations) {
+        finalOutputs.resize(numCons);
+        hasOutputs = (ReevaluateX(numCons, finalOutputs.data()) == SUCCESS);
+      }
+      if (hasOutputs) {
+        // Largest violations first. Excel errors come back as NaN, which
+        // can't be ordered, so they count as the largest of all.
+        vector<std::pair<double, int> > violations;
+        for (int i = numObjs; i < numCons; ++i) {
+          if (std::isnan(finalOutputs[i])) {
+            violations.push_back(std::make_pair(
+                -std::numeric_limits<double>::infinity(), i - numObjs));
+          } else if (finalOutputs[i] > 0) {
+            violations.push_back(std::make_pair(-finalOutputs[i], i - numObjs));
+          }
+        }
+        std::sort(violations.begin(), violations.end());
+        out << endl << "Constraints at the solution: " << violations.size()
+            << " of " << numCons - numObjs << " violated" << endl;
+        for (size_t k = 0; k < violations.size() &&
+                           k < static_cast<size_t>(MAX_REPORTED_VIOLATIONS);
+             ++k) {
+          int constraint = violations[k].second;
+          out << "  constraint " << constraint + 1 << " (group "
+              << aggregator->GetGroup(constraint) + 1 << "): ";
+          if (std::isnan(finalOutputs[numObjs + constraint])) {
+            out << "error" << endl;
+          } else {
+            out << finalOutputs[numObjs + constraint] << endl;
+          }
+        }
       }
-      const double bestPoint = bestSol->get_f().value();
-      UpdateVars(finalVars, numVars, &bestPoint, feasibility);
-      delete[] finalVars;
     }
 
     // Get return value
     NomadResult retval = OPTIMAL;
-    if (mads->get_stats().get_real_time() == p.get_max_time()) {
+    if (stoppedTime) {
       retval = feasibility ? SOLVE_STOPPED_TIME : SOLVE_STOPPED_TIME_INF;
-    } else if (mads->get_stats().get_bb_eval() == p.get_max_bb_eval()) {
+    } else if (stoppedIter) {
       retval = feasibility ? SOLVE_STOPPED_ITER : SOLVE_STOPPED_ITER_INF;
+    } else if (stalled) {
+      // The monitor only stops solves with a feasible incumbent
+      retval = feasibility ? SOLVE_STOPPED_STALL : INFEASIBLE;
     } else if (stopflag == NOMAD::CTRL_C) {
       retval = USER_CANCELLED;
     } else if (!feasibility) {
       retval = INFEASIBLE;
     }
 
-    // Free Memory
-    delete mads;
+    if (stalled) {
+      out << endl << "Stall monitor: stopped after the objective improved by "
+          << "less than " << stallMonitor->GetTolerance() << " (relative) "
+          << "over the last " << stallMonitor->GetWindow()
+          << " evaluations" << endl;
+    }
+    if (hiddenConstraints) {
+      out << endl << "Hidden constraint model: "
+          << hiddenConstraints->GetNumFailed() << " evaluations failed, "
+          << hiddenConstraints->GetNumSkipped()
+          << " predicted failures skipped without recalculating" << endl;
+    }
+    if (lipschitzFilter) {
+      out << endl << "Lipschitz filter: " << lipschitzFilter->GetNumSkipped()
+          << " points rejected without recalculating ("
+          << lipschitzFilter->GetNumSkippedObjective()
+          << " on the objective), " << lipschitzFilter->GetNumBoundsBroken()
+          << " of " << lipschitzFilter->GetNumChecked()
+          << " rejections checked broke their bound" << endl;
+      const vector<LipschitzRejection>& rejections =
+          lipschitzFilter->GetRejections();
+      for (size_t k = 0; k < rejections.size(); ++k) {
+        const LipschitzRejection& rejection = rejections[k];
+        out << "  (";
+        for (int i = 0; i < numVars && i < MAX_REPORTED_VALUES; ++i) {
+          out << (i > 0 ? ", " : "") << rejection.x[i];
+        }
+        out << (numVars > MAX_REPORTED_VALUES ? ", ...)" : ")");
+        if (rejection.output < numObjs) {
+          out << ": objective";
+        } else {
+          out << ": constraint " << rejection.output - numObjs + 1;
+        }
+        out << " at least " << rejection.bound << endl;
+      }
+    }
+    if (replication) {
+      out << endl << "Noisy replication: "
+          << replication->GetNumReplicated() << " points replicated using "
+          << replication->GetNumExtraReads() << " extra evaluations";
+      if (replication->GetNoiseEstimate() >= 0) {
+        out << ", objective noise standard deviation "
+            << replication->GetNoiseEstimate();
+      }
+      out << endl;
+    }
+
+    if (numSurrogateEvals > 0) {
+      out << endl << "Surrogate: " << numSurrogateEvals
+          << " low-fidelity and " << numEvals << " full evaluations" << endl;
+    }
+    if (numFullEvals > 0) {
+      out << endl << "Full evaluations took " << fullEvalSeconds / numFullEvals
+          << " seconds on average" << endl;
+    }
+    if (numBlockSteps > 0) {
+      out << "Evaluation order: " << numBlocks << " blocks reordered to change "
+          << static_cast<double>(numTourChanges) / numBlockSteps
+          << " variables between points on average, against "
+          << static_cast<double>(numListedChanges) / numBlockSteps
+          << " in NOMAD's order" << endl;
+    }
+    if (numPrechecked > 0) {
+      out << endl << "Pre-check: " << numRejected << " of " << numPrechecked
+          << " points rejected without a full recalculation" << endl;
+    }
+
+    if (history) {
+      const double bytesPerMb = 1024 * 1024;
+      out << endl << "Evaluation history: " << history->GetNumAdded()
+          << " points added, " << history->GetNumEvicted() << " evicted, "
+          << history->GetNumStored() << " stored using at most "
+          << history->GetPeakMemory() / bytesPerMb << " MB" << endl;
+      vector<double> incumbentX;
+      vector<double> incumbentOutputs;
+      if (history->GetIncumbent(&incumbentX, &incumbentOutputs) &&
+          numCons > numObjs) {
+        int worst = numObjs;
+        for (int i = numObjs; i < numCons; ++i) {
+          if (incumbentOutputs[i] > incumbentOutputs[worst]) {
+            worst = i;
+          }
+        }
+        out << "Largest constraint value at the incumbent is "
+            << incumbentOutputs[worst] << " (constraint "
+            << worst - numObjs + 1 << ")" << endl;
+      }
+    }
+    size_t peakMemory = GetPeakMemoryUsage();
+    if (peakMemory > 0) {
+      out << endl << "Peak memory: " << peakMemory / (1024.0 * 1024.0)
+          << " MB" << endl;
+    }
+
+    if (summary != nullptr) {
+      summary->hasSolution = hasSolution;
+      summary->feasible = hasSolution && feasibility;
+      summary->objective = bestPoint;
+      summary->numEvals = numEvals;
+      summary->seconds = solveSeconds;
+      if (hasSolution) {
+        summary->x = finalVars;
+        summary->bestPoints.push_back(finalVars);
+      }
+      if (history) {
+        vector<vector<double> > best = history->GetBestPoints(
+            MAX_SUMMARY_POINTS);
+        summary->bestPoints.insert(summary->bestPoints.end(), best.begin(),
+                                   best.end());
+      }
+    }
 
     out << endl << endl << "NOMAD Solve Return Value: " << retval << endl;
     logFile.close();
@@ -4,6 +4,8 @@
 #ifndef SRC_NOMADINTERFACE_H_
 #define SRC_NOMADINTERFACE_H_
 
+#include <vector>
+
 #include "nomad.hpp"
 
 namespace OPENSOLVER {
@@ -27,7 +29,20 @@ enum NomadResult {
   SOLVE_STOPPED_TIME = 3,
   INFEASIBLE = 4,
   SOLVE_STOPPED_ITER_INF = 10,
-  SOLVE_STOPPED_TIME_INF = 11
+  SOLVE_STOPPED_TIME_INF = 11,
+  SOLVE_STOPPED_STALL = 12
+};
+
+// Outcome of a solve, for callers that run several related solves
+struct SolveSummary {
+  bool                               hasSolution;
+  bool                               feasible;
+  double                             objective;
+  std::vector<double>                x;
+  // The solution followed by the best points in the evaluation history
+  std::vector<std::vector<double> >  bestPoints;
+  int                                numEvals;
+  double                             seconds;
 };
 
 /**
@@ -35,6 +50,20 @@ enum NomadResult {
  */
 NomadResult RunNomad();
 
+/**
+ * Runs entire NOMAD process, also starting from the given points
+ *
+ * The seeds are moved inside the bounds and rounded for integer variables,
+ * and ignored by PSD-MADS.
+ * @param seeds Extra starting points, such as the solutions of related solves
+ * @param summary Set to the outcome of the solve, or nullptr
+ * @param appendLog Whether to add to the log file rather than replace it,
+ *                  so the logs of all solves in a batch are kept
+ * @return The result of the solve
+ */
+NomadResult RunNomadFromSeeds(const std::vector<std::vector<double> >& seeds,
+                              SolveSummary* summary, bool appendLog);
+
 #ifdef __APPLE__
 /**
  * Runs entire NOMAD process and loads result into Excel
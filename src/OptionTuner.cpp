@@ -0,0 +1,194 @@
+// OptionTuner.cpp
+
+#include "OptionTuner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "NomadInterface.hpp"
+
+namespace OPENSOLVER {
+
+// Above this many variables, quadratic models need too many points to be
+// worth building and the cheaper N+1 poll is used
+const int LARGE_DIMENSION = 50;
+
+// Above this many variables, models are only built if evaluations are slow
+const int MEDIUM_DIMENSION = 20;
+
+// Variables times outputs above which the models cost more than they save
+const double MAX_MODEL_SIZE = 2000;
+
+// Evaluations faster than this are cheaper than building a model
+const double CHEAP_EVALUATION_SECONDS = 1e-3;
+
+// Rounded N+1 directions poll integer variables poorly, so models with at
+// least this fraction of integer variables poll in both directions
+const double INTEGER_HEAVY_FRACTION = 0.5;
+
+// NOMAD's own initial mesh relative to the variable ranges, and the smallest
+// one we will choose from an earlier solve
+const double DEFAULT_RELATIVE_MESH = 0.1;
+const double MIN_RELATIVE_MESH = 1e-3;
+
+// Models kept in the history file, the least recently solved are dropped
+const int MAX_HISTORY_MODELS = 100;
+
+// Earlier solves are averaged with at most this weight on the old average
+const int MAX_HISTORY_WEIGHT = 4;
+
+// 64-bit FNV-1a hash, used for the fingerprint
+void HashBytes(const void* data, size_t size, uint64_t* hash) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    *hash ^= bytes[i];
+    *hash *= 1099511628211ULL;
+  }
+}
+
+OptionTuner::OptionTuner(const std::vector<int>& varTypes,
+                         const std::vector<double>& lowerBounds,
+                         const std::vector<double>& upperBounds,
+                         int numCons, int numObjs,
+                         const std::string& historyPath) :
+    _n(static_cast<int>(varTypes.size())),
+    _numIntegers(0),
+    _numConstraints(numCons - numObjs),
+    _lowerBounds(lowerBounds),
+    _upperBounds(upperBounds),
+    _allBounded(true),
+    _historyPath(historyPath),
+    _numSolves(0),
+    _evalSeconds(0),
+    _relativeStep(-1) {
+  uint64_t hash = 14695981039346656037ULL;
+  HashBytes(&_n, sizeof(_n), &hash);
+  HashBytes(&numCons, sizeof(numCons), &hash);
+  HashBytes(&numObjs, sizeof(numObjs), &hash);
+  for (int i = 0; i < _n; ++i) {
+    if (varTypes[i] != CONTINUOUS) {
+      ++_numIntegers;
+    }
+    if (!(upperBounds[i] < NOMAD::INF && lowerBounds[i] > -1e10)) {
+      _allBounded = false;
+    }
+    HashBytes(&varTypes[i], sizeof(varTypes[i]), &hash);
+    HashBytes(&lowerBounds[i], sizeof(lowerBounds[i]), &hash);
+    HashBytes(&upperBounds[i], sizeof(upperBounds[i]), &hash);
+  }
+  std::ostringstream fingerprint;
+  fingerprint << std::hex << hash;
+  _fingerprint = fingerprint.str();
+
+  std::ifstream history(_historyPath.c_str());
+  std::string line;
+  while (std::getline(history, line)) {
+    std::istringstream fields(line);
+    std::string key;
+    if (fields >> key && key == _fingerprint) {
+      if (!(fields >> _numSolves >> _evalSeconds >> _relativeStep)) {
+        _numSolves = 0;
+      }
+    }
+  }
+}
+
+std::vector<std::string> OptionTuner::ChooseOptions(int maxBlockSize,
+                                                    bool useWarmstart) const {
+  std::vector<std::string> options;
+  std::ostringstream option;
+
+  bool integerHeavy = _numIntegers >= INTEGER_HEAVY_FRACTION * _n;
+  bool cheapEvaluations = (_numSolves > 0 &&
+                           _evalSeconds < CHEAP_EVALUATION_SECONDS);
+  bool useModels = !(_n > LARGE_DIMENSION || _numIntegers == _n ||
+                     static_cast<double>(_n) * (_numConstraints + 1) >
+                         MAX_MODEL_SIZE ||
+                     (cheapEvaluations && _n > MEDIUM_DIMENSION));
+
+  if (integerHeavy) {
+    options.push_back("DIRECTION_TYPE ORTHO 2N");
+  } else if (!useModels) {
+    // The default N+1 QUAD directions would still build a model every poll
+    options.push_back("DIRECTION_TYPE ORTHO N+1 NEG");
+  }
+  if (!useModels) {
+    options.push_back("MODEL_SEARCH no");
+  }
+
+  if (maxBlockSize > 1) {
+    int pollSize = integerHeavy ? 2 * _n : _n + 1;
+    option.str("");
+    option << "BB_MAX_BLOCK_SIZE " << std::min(maxBlockSize, pollSize);
+    options.push_back(option.str());
+  }
+
+  // If the last solve from the user's values ended close by, don't start
+  // with a mesh that overshoots it
+  if (useWarmstart && _allBounded && _numSolves > 0 && _relativeStep >= 0 &&
+      _relativeStep < DEFAULT_RELATIVE_MESH) {
+    option.str("");
+    option << "INITIAL_MESH_SIZE r"
+           << std::max(_relativeStep, MIN_RELATIVE_MESH);
+    options.push_back(option.str());
+  }
+
+  return options;
+}
+
+void OptionTuner::RecordSolve(double evalSeconds,
+                              const std::vector<double>& x0,
+                              const std::vector<double>& x) const {
+  double relativeStep = -1;
+  if (_allBounded && !x0.empty()) {
+    relativeStep = 0;
+    for (int i = 0; i < _n; ++i) {
+      double range = _upperBounds[i] - _lowerBounds[i];
+      if (range > 0) {
+        relativeStep = std::max(relativeStep, std::fabs(x[i] - x0[i]) / range);
+      }
+    }
+  }
+
+  int weight = std::min(_numSolves, MAX_HISTORY_WEIGHT);
+  if (_numSolves > 0) {
+    evalSeconds = (weight * _evalSeconds + evalSeconds) / (weight + 1);
+    if (relativeStep < 0) {
+      relativeStep = _relativeStep;
+    } else if (_relativeStep >= 0) {
+      relativeStep = (weight * _relativeStep + relativeStep) / (weight + 1);
+    }
+  }
+
+  // Rewrite the file with this model moved to the end
+  std::vector<std::string> lines;
+  std::ifstream oldHistory(_historyPath.c_str());
+  std::string line;
+  while (std::getline(oldHistory, line)) {
+    std::istringstream fields(line);
+    std::string key;
+    if (fields >> key && key != _fingerprint) {
+      lines.push_back(line);
+    }
+  }
+  oldHistory.close();
+
+  std::ostringstream entry;
+  entry << _fingerprint << " " << _numSolves + 1 << " " << evalSeconds << " "
+        << relativeStep;
+  lines.push_back(entry.str());
+
+  std::ofstream history(_historyPath.c_str(), std::ios::out);
+  const size_t maxLines = MAX_HISTORY_MODELS;
+  size_t first = lines.size() > maxLines ? lines.size() - maxLines : 0;
+  for (size_t i = first; i < lines.size(); ++i) {
+    history << lines[i] << std::endl;
+  }
+}
+
+}  // namespace OPENSOLVER
@@ -0,0 +1,79 @@
+// OptionTuner.hpp
+// Chooses NOMAD options from the features of the model being solved
+//
+// The choices are based on the dimension, the mix of integer and binary
+// variables, the number of constraints and, once the model has been solved
+// before, the measured time per evaluation and how far the solution moved
+// from the starting point. Earlier solves are looked up in a history file by
+// a fingerprint of the model's variables and constraints.
+
+#ifndef SRC_OPTIONTUNER_H_
+#define SRC_OPTIONTUNER_H_
+
+#include <string>
+#include <vector>
+
+namespace OPENSOLVER {
+
+class OptionTuner {
+ public:
+  /**
+   * @param varTypes The type of each variable, see VarType
+   * @param lowerBounds The lower bound of each variable
+   * @param upperBounds The upper bound of each variable, NOMAD::INF if none
+   * @param numCons The number of outputs, including the objectives
+   * @param numObjs The number of objectives
+   * @param historyPath The file holding the results of earlier solves
+   */
+  OptionTuner(const std::vector<int>& varTypes,
+              const std::vector<double>& lowerBounds,
+              const std::vector<double>& upperBounds,
+              int numCons, int numObjs, const std::string& historyPath);
+
+  /**
+   * Chooses the options for this model
+   *
+   * @param maxBlockSize The largest block of points the evaluator can take
+   * @param useWarmstart True if the solve starts from the user's values
+   * @return The chosen options as NOMAD parameter strings
+   */
+  std::vector<std::string> ChooseOptions(int maxBlockSize,
+                                         bool useWarmstart) const;
+
+  /**
+   * Saves the result of the solve to the history file
+   *
+   * @param evalSeconds The average time per full evaluation
+   * @param x0 The user's starting point, or empty if the solve started from
+   *           a design instead. The step to the solution is only learnt
+   *           from the user's starting point.
+   * @param x The solution
+   */
+  void RecordSolve(double evalSeconds, const std::vector<double>& x0,
+                   const std::vector<double>& x) const;
+
+  // Fingerprint identifying the model in the history file
+  const std::string& GetFingerprint() const { return _fingerprint; }
+
+  // Number of earlier solves of the model found in the history file
+  int GetNumEarlierSolves() const { return _numSolves; }
+
+ private:
+  int                  _n;
+  int                  _numIntegers;   // Including binaries
+  int                  _numConstraints;
+  std::vector<double>  _lowerBounds;
+  std::vector<double>  _upperBounds;
+  bool                 _allBounded;
+  std::string          _historyPath;
+  std::string          _fingerprint;
+
+  // From the history file, _numSolves is 0 if the model is new
+  int                  _numSolves;
+  double               _evalSeconds;
+  double               _relativeStep;  // Largest move from x0 over the range
+};
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_OPTIONTUNER_H_
@@ -0,0 +1,486 @@
+// ParallelSpaceDecomposition.cpp
+
+#include "ParallelSpaceDecomposition.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EvaluationBackend.hpp"
+#include "ExcelCallbacks.hpp"
+
+namespace OPENSOLVER {
+
+// Mesh size of the first subproblems, relative to each variable's scale
+const double PSD_INITIAL_MESH_FACTOR = 0.1;
+
+// The solve stops once the relative mesh size falls below this
+const double PSD_MIN_MESH_FACTOR = 1e-6;
+
+// NOMAD 3 keeps unsynchronised process-wide state, such as its random number
+// generator, the evaluation point tags and the static Mads flags. Workers
+// hold this whenever they are in NOMAD, and only release it while waiting for
+// an evaluation, so the subproblems overlap in their evaluations only.
+std::mutex psdNomadMutex;
+
+// Incumbent and mesh shared between the workers
+class PsdShared {
+ public:
+  PsdShared(int m, int numObjs, int numWorkers, int maxBbEval,
+            int maxTime) :
+      _m(m),
+      _numObjs(numObjs),
+      _numWorkers(numWorkers),
+      _maxBbEval(maxBbEval),
+      _maxTime(maxTime),
+      _start(std::chrono::steady_clock::now()),
+      _hasIncumbent(false),
+      _feasible(false),
+      _f(0),
+      _h(0),
+      _meshFactor(PSD_INITIAL_MESH_FACTOR),
+      _failedSubproblems(0),
+      _numSubproblems(0),
+      _numImprovements(0),
+      _bbEval(0),
+      _stopped(false),
+      _stopReason(NOMAD::NO_STOP) {}
+
+  bool IsStopped() const { return _stopped; }
+
+  void Stop(NOMAD::stop_type reason) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_stopped) {
+      _stopReason = reason;
+      _stopped = true;
+    }
+  }
+
+  void Fail(const std::string& error) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_error.empty()) {
+      _error = error;
+    }
+    if (!_stopped) {
+      _stopReason = NOMAD::ERROR;
+      _stopped = true;
+    }
+  }
+
+  // Claims one evaluation from the budget, stopping the solve if there is none
+  bool ReserveEval() {
+    if (_stopped) {
+      return false;
+    }
+    if (_maxTime > 0 && GetRealTime() >= _maxTime) {
+      Stop(NOMAD::MAX_TIME_REACHED);
+      return false;
+    }
+    if (_maxBbEval > 0 && ++_bbEval > _maxBbEval) {
+      --_bbEval;
+      Stop(NOMAD::MAX_BB_EVAL_REACHED);
+      return false;
+    } else if (_maxBbEval <= 0) {
+      ++_bbEval;
+    }
+    return true;
+  }
+
+  // Gets the starting point and mesh size for a new subproblem
+  void GetStart(std::vector<double>* x, double* meshFactor) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    *x = _x;
+    *meshFactor = _meshFactor;
+  }
+
+  // Gets the incumbent objective to show in the host status
+  bool GetStatus(double* bestSolution, bool* feasibility) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    *bestSolution = _f;
+    *feasibility = _feasible;
+    return _hasIncumbent;
+  }
+
+  // Copies the outputs of the incumbent if x is the incumbent
+  bool LookupIncumbent(const std::vector<double>& x,
+                       std::vector<double>* outputs) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_hasIncumbent || x != _x) {
+      return false;
+    }
+    *outputs = _outputs;
+    return true;
+  }
+
+  // Sets the starting point before any workers are running
+  void SetStart(const std::vector<double>& x) {
+    _x = x;
+  }
+
+  /**
+   * Merges the result of a subproblem into the incumbent
+   *
+   * @param x The best point of the subproblem, or nullptr if there was none
+   * @param outputs The outputs at x
+   * @param isSubproblem False when merging the starting point
+   */
+  void Merge(const std::vector<double>* x, const std::vector<double>* outputs,
+             bool isSubproblem = true) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    bool improved = false;
+    if (x != nullptr) {
+      double f, h;
+      if (Measure(*outputs, &f, &h)) {
+        bool feasible = (h == 0);
+        if (!_hasIncumbent) {
+          improved = true;
+        } else if (feasible != _feasible) {
+          improved = feasible;
+        } else {
+          improved = feasible ? (f < _f) : (h < _h);
+        }
+        if (improved) {
+          _x = *x;
+          _outputs = *outputs;
+          _f = f;
+          _h = h;
+          _feasible = feasible;
+          _hasIncumbent = true;
+        }
+      }
+    }
+
+    if (!isSubproblem) {
+      return;
+    }
+
+    // A full round of subproblems without improvement refines the mesh
+    ++_numSubproblems;
+    if (improved) {
+      ++_numImprovements;
+      _failedSubproblems = 0;
+    } else if (++_failedSubproblems >= _numWorkers) {
+      _failedSubproblems = 0;
+      _meshFactor /= 2;
+      if (_meshFactor < PSD_MIN_MESH_FACTOR && !_stopped) {
+        _stopReason = NOMAD::MIN_MESH_SIZE_REACHED;
+        _stopped = true;
+      }
+    }
+  }
+
+  void FillResult(PsdResult* result) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    result->hasSolution = _hasIncumbent;
+    result->feasible = _hasIncumbent && _feasible;
+    result->x = _x;
+    result->f = _f;
+    result->stopReason = _stopReason;
+    result->bbEval = _bbEval;
+    result->realTime = GetRealTime();
+  }
+
+  const std::string& GetError() const { return _error; }
+  int GetNumSubproblems() const { return _numSubproblems; }
+  int GetNumImprovements() const { return _numImprovements; }
+
+ private:
+  int GetRealTime() const {
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - _start).count());
+  }
+
+  // Gets the objective and infeasibility of a set of outputs, returning
+  // false if any output is an Excel error
+  bool Measure(const std::vector<double>& outputs, double* f, double* h) {
+    *f = 0;
+    *h = 0;
+    for (int i = 0; i < _m; ++i) {
+      if (std::isnan(outputs[i])) {
+        return false;
+      }
+      if (i < _numObjs) {
+        if (i == 0) {
+          *f = outputs[i];
+        }
+      } else if (outputs[i] > 0) {
+        *h += outputs[i] * outputs[i];
+      }
+    }
+    return true;
+  }
+
+  int                    _m;
+  int                    _numObjs;
+  int                    _numWorkers;
+  int                    _maxBbEval;
+  int                    _maxTime;
+  std::chrono::steady_clock::time_point _start;
+
+  std::mutex             _mutex;
+  bool                   _hasIncumbent;
+  std::vector<double>    _x;
+  std::vector<double>    _outputs;
+  bool                   _feasible;
+  double                 _f;
+  double                 _h;
+  double                 _meshFactor;
+  int                    _failedSubproblems;
+  int                    _numSubproblems;
+  int                    _numImprovements;
+  std::atomic<int>       _bbEval;
+  std::atomic<bool>      _stopped;
+  NOMAD::stop_type       _stopReason;
+  std::string            _error;
+};
+
+//*--------------------------------------*/
+//*         subproblem evaluator         */
+//*--------------------------------------*/
+class Subspace_Evaluator : public NOMAD::Evaluator {
+ private:
+  int                            _n;
+  int                            _m;
+  PsdShared*                     _shared;
+  EvaluationBackend*             _backend;
+  std::unique_lock<std::mutex>*  _nomadLock;
+  mutable std::vector<double>    _px;
+  mutable std::vector<double>    _fx;
+
+ public:
+  Subspace_Evaluator(const NOMAD::Parameters &p, int n, int m,
+                     PsdShared* shared, EvaluationBackend* backend,
+                     std::unique_lock<std::mutex>* nomadLock) :
+      Evaluator(p),
+      _n(n),
+      _m(m),
+      _shared(shared),
+      _backend(backend),
+      _nomadLock(nomadLock),
+      _px(n),
+      _fx(m) {}
+
+  bool eval_x(NOMAD::Eval_Point& x,
+              const NOMAD::Double& h_max,
+              bool& count_eval) const override;
+};
+
+bool Subspace_Evaluator::eval_x(NOMAD::Eval_Point& x,
+                                const NOMAD::Double& /*h_max*/,
+                                bool& count_eval) const {
+  for (int i = 0; i < _n; ++i) {
+    _px[i] = x[i].value();
+  }
+
+  // Every subproblem starts at the incumbent, which is already evaluated
+  count_eval = false;
+  if (!_shared->LookupIncumbent(_px, &_fx)) {
+    if (!_shared->ReserveEval()) {
+      return false;
+    }
+
+    double bestValue;
+    bool feasibility;
+    const double* bestSol = nullptr;
+    if (_shared->GetStatus(&bestValue, &feasibility)) {
+      bestSol = &bestValue;
+    }
+
+    // Let the other workers run NOMAD while this one waits
+    EXCEL_RC rc;
+    _nomadLock->unlock();
+    try {
+      rc = _backend->Evaluate(_px.data(), _n, _m, bestSol, feasibility,
+                              _fx.data());
+    } catch (...) {
+      _nomadLock->lock();
+      throw;
+    }
+    _nomadLock->lock();
+    if (rc != SUCCESS) {
+      if (GetErrorCode(rc) == ESC_ABORT) {
+        _shared->Stop(NOMAD::CTRL_C);
+      } else {
+        _shared->Fail(GetExcelCallbackErrorMessage(rc));
+      }
+      return false;
+    }
+    count_eval = true;
+  }
+
+  for (int i = 0; i < _m; ++i) {
+    x.set_bb_output(i, _fx[i]);
+  }
+  return true;
+}
+
+// Repeatedly solves random subproblems until the shared state says to stop
+void RunPsdWorker(int workerIndex, const NOMAD::Parameters& p,
+                  const std::vector<double>& scales,
+                  const PsdSettings& settings, PsdShared* shared,
+                  EvaluationBackend* backend) {
+  const int n = p.get_dimension();
+  const int m = p.get_bb_nb_outputs();
+  const int subsetSize = std::min(settings.subsetSize, n);
+  const std::vector<NOMAD::bb_input_type>& bbit = p.get_bb_input_type();
+
+  std::mt19937 rng(workerIndex + 1);
+  std::vector<int> order(n);
+  for (int i = 0; i < n; ++i) {
+    order[i] = i;
+  }
+
+  std::vector<double> start;
+  double meshFactor;
+  std::unique_lock<std::mutex> nomadLock(psdNomadMutex);
+  try {
+    while (!shared->IsStopped()) {
+      std::shuffle(order.begin(), order.end(), rng);
+      shared->GetStart(&start, &meshFactor);
+
+      NOMAD::Point x0(n);
+      NOMAD::Point delta(n);
+      for (int i = 0; i < n; ++i) {
+        x0[i] = start[i];
+      }
+      for (int j = 0; j < subsetSize; ++j) {
+        int i = order[j];
+        if (bbit[i] == NOMAD::CONTINUOUS) {
+          double scale = scales[i] > 0 ? scales[i]
+                                       : std::max(1.0, std::fabs(start[i]));
+          delta[i] = meshFactor * scale;
+        }
+      }
+
+      std::ostringstream quiet;
+      NOMAD::Display subOut(quiet);
+      NOMAD::Parameters sp(subOut);
+      sp.set_DIMENSION(n);
+      sp.set_X0(x0);
+      sp.set_LOWER_BOUND(p.get_lb());
+      sp.set_UPPER_BOUND(p.get_ub());
+      sp.set_BB_INPUT_TYPE(bbit);
+      sp.set_BB_OUTPUT_TYPE(p.get_bb_output_type());
+      for (int j = subsetSize; j < n; ++j) {
+        sp.set_FIXED_VARIABLE(order[j]);
+      }
+      sp.set_INITIAL_MESH_SIZE(delta);
+      sp.set_MAX_BB_EVAL(settings.subproblemEvals);
+      // Failed evaluations aren't counted, so also bound the total
+      sp.set_MAX_EVAL(2 * settings.subproblemEvals);
+      sp.set_DISPLAY_DEGREE(0);
+      sp.check();
+
+      Subspace_Evaluator ev(sp, n, m, shared, backend, &nomadLock);
+      NOMAD::Mads subMads(sp, &ev);
+      subMads.run();
+
+      const NOMAD::Eval_Point* best = subMads.get_best_feasible();
+      if (best == nullptr) {
+        best = subMads.get_best_infeasible();
+      }
+      if (best != nullptr) {
+        std::vector<double> x(n);
+        std::vector<double> outputs(m);
+        for (int i = 0; i < n; ++i) {
+          x[i] = (*best)[i].value();
+        }
+        for (int i = 0; i < m; ++i) {
+          outputs[i] = best->get_bb_outputs()[i].value();
+        }
+        shared->Merge(&x, &outputs);
+      } else {
+        shared->Merge(nullptr, nullptr);
+      }
+    }
+  }
+  catch (std::exception& e) {
+    shared->Fail(e.what());
+  }
+}
+
+PsdResult RunParallelSpaceDecomposition(const NOMAD::Parameters& p,
+                                        const NOMAD::Point& x0, int numObjs,
+                                        const PsdSettings& settings,
+                                        const NOMAD::Display& out) {
+  const int n = p.get_dimension();
+  const int m = p.get_bb_nb_outputs();
+  PsdShared shared(m, numObjs, settings.numWorkers, p.get_max_bb_eval(),
+                   p.get_max_time());
+
+  // Scale used for the mesh of each variable, zero if unbounded
+  std::vector<double> scales(n);
+  for (int i = 0; i < n; ++i) {
+    double lower = p.get_lb()[i].value();
+    double upper = p.get_ub()[i].value();
+    scales[i] = (upper < NOMAD::INF && lower > -1e10) ? upper - lower : 0;
+  }
+
+  // Evaluate the starting point here so the workers don't all repeat it
+  std::vector<double> start(n);
+  std::vector<double> outputs(m);
+  for (int i = 0; i < n; ++i) {
+    start[i] = x0[i].value();
+  }
+  shared.SetStart(start);
+  if (shared.ReserveEval()) {
+    EXCEL_RC rc = EvaluateX(start.data(), n, m, nullptr, false,
+                            outputs.data());
+    if (GetErrorCode(rc) == ESC_ABORT) {
+      shared.Stop(NOMAD::CTRL_C);
+    } else {
+      ValidateReturnCode(rc);
+      shared.Merge(&start, &outputs, false);
+    }
+  }
+
+  HostBackend host;
+  EvaluationDispatcher dispatcher(&host);
+  std::vector<std::unique_ptr<EvaluationBackend> > ownedBackends;
+  std::vector<std::thread> workers;
+  std::atomic<int> running(settings.numWorkers);
+  for (int w = 0; w < settings.numWorkers; ++w) {
+    EvaluationBackend* backend = CreateWorkerBackend(w);
+    if (backend == nullptr) {
+      backend = &dispatcher;
+    } else {
+      ownedBackends.emplace_back(backend);
+    }
+    workers.emplace_back([&, w, backend] {
+      RunPsdWorker(w, p, scales, settings, &shared, backend);
+      if (--running == 0) {
+        dispatcher.Stop();
+      }
+    });
+  }
+
+  // Serve the workers' evaluations on this thread until they all finish
+  dispatcher.Serve();
+  for (size_t w = 0; w < workers.size(); ++w) {
+    workers[w].join();
+  }
+
+  if (!shared.GetError().empty()) {
+    throw std::runtime_error(shared.GetError());
+  }
+
+  PsdResult result;
+  shared.FillResult(&result);
+  out << endl << "PSD-MADS: " << settings.numWorkers << " workers solved "
+      << shared.GetNumSubproblems() << " subproblems with "
+      << shared.GetNumImprovements() << " improvements using "
+      << result.bbEval << " evaluations" << endl;
+  return result;
+}
+
+}  // namespace OPENSOLVER
@@ -0,0 +1,62 @@
+// ParallelSpaceDecomposition.hpp
+// Thread-based parallel space decomposition (PSD-MADS) for large models
+//
+// Each worker thread repeatedly runs a small MADS subproblem over a random
+// subset of the variables, with the others fixed at the shared incumbent.
+// Improvements are merged back into the shared incumbent, and the mesh size
+// given to new subproblems is halved whenever a full round of subproblems
+// fails to improve it. Evaluations go through an EvaluationBackend per
+// worker, so the host thread serves them unless a backend factory is set.
+// NOMAD itself isn't thread-safe, so the workers take turns running it and
+// only overlap while waiting for their evaluations.
+//
+// The subproblems bypass the main evaluator, so the options that act on it
+// (hidden constraints, replication, the history store, the surrogate, the
+// Lipschitz filter and so on) don't apply. RunNomad logs the ones that are
+// set.
+
+#ifndef SRC_PARALLELSPACEDECOMPOSITION_H_
+#define SRC_PARALLELSPACEDECOMPOSITION_H_
+
+#include <vector>
+
+#include "nomad.hpp"
+
+namespace OPENSOLVER {
+
+struct PsdSettings {
+  int numWorkers;       // Number of worker threads
+  int subsetSize;       // Number of free variables in each subproblem
+  int subproblemEvals;  // Evaluation budget of each subproblem
+};
+
+struct PsdResult {
+  bool                 hasSolution;
+  bool                 feasible;
+  std::vector<double>  x;
+  double               f;
+  NOMAD::stop_type     stopReason;
+  int                  bbEval;
+  int                  realTime;
+};
+
+/**
+ * Runs PSD-MADS on the problem described by the parameters
+ *
+ * Must be called from the host thread, which serves the evaluations of
+ * workers that use the default backend.
+ * @param p The checked parameters of the full problem
+ * @param x0 The starting point
+ * @param numObjs The number of objectives among the outputs
+ * @param settings The decomposition settings
+ * @param out The display for progress messages
+ * @return The best point found and why the solve stopped
+ */
+PsdResult RunParallelSpaceDecomposition(const NOMAD::Parameters& p,
+                                        const NOMAD::Point& x0, int numObjs,
+                                        const PsdSettings& settings,
+                                        const NOMAD::Display& out);
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_PARALLELSPACEDECOMPOSITION_H_
@@ -0,0 +1,147 @@
+// ScenarioBatch.cpp
+
+#include "ScenarioBatch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ExcelCallbacks.hpp"
+
+namespace OPENSOLVER {
+
+// Most earlier scenarios that seed a solve, and most points taken from each
+const int MAX_SEED_SCENARIOS = 3;
+const int MAX_SEEDS_PER_SCENARIO = 2;
+
+struct ScenarioRun {
+  std::vector<double>  parameters;
+  NomadResult          result;
+  SolveSummary         summary;
+};
+
+// Distance between the parameters of two scenarios, each parameter relative
+// to its size. Scenarios with different numbers of parameters are unrelated.
+double GetScenarioDistance(const std::vector<double>& a,
+                           const std::vector<double>& b) {
+  if (a.size() != b.size()) {
+    return std::numeric_limits<double>::infinity();
+  }
+  double distance = 0;
+  for (size_t j = 0; j < a.size(); ++j) {
+    double scale = std::max(1.0, std::max(std::fabs(a[j]), std::fabs(b[j])));
+    double difference = (a[j] - b[j]) / scale;
+    distance += difference * difference;
+  }
+  return distance;
+}
+
+// Gets the best points of the earlier scenarios closest to the given one.
+// Ties go to the latest scenario.
+std::vector<std::vector<double> > GetSeeds(
+    const std::vector<ScenarioRun>& runs,
+    const std::vector<double>& parameters) {
+  std::vector<std::pair<double, int> > nearest;
+  for (size_t k = 0; k < runs.size(); ++k) {
+    double distance = GetScenarioDistance(runs[k].parameters, parameters);
+    if (!runs[k].summary.bestPoints.empty() && !std::isinf(distance)) {
+      nearest.push_back(std::make_pair(distance, -static_cast<int>(k)));
+    }
+  }
+  std::sort(nearest.begin(), nearest.end());
+
+  std::vector<std::vector<double> > seeds;
+  for (size_t k = 0; k < nearest.size() &&
+                     k < static_cast<size_t>(MAX_SEED_SCENARIOS); ++k) {
+    const std::vector<std::vector<double> >& points =
+        runs[-nearest[k].second].summary.bestPoints;
+    for (size_t i = 0; i < points.size() &&
+                       i < static_cast<size_t>(MAX_SEEDS_PER_SCENARIO); ++i) {
+      seeds.push_back(points[i]);
+    }
+  }
+  return seeds;
+}
+
+// Writes the message for a failed callback to the batch log
+void LogBatchError(const std::string& logPath, EXCEL_RC rc) {
+  std::ofstream(logPath.c_str(), std::ios::app)
+      << GetExcelCallbackErrorMessage(rc) << std::endl;
+}
+
+NomadResult RunScenarioBatch() {
+  // All solves go to one log, each after a heading naming its scenario
+  std::string logPath;
+  if (GetLogFilePath(&logPath) != SUCCESS) {
+    return LOG_FILE_ERROR;
+  }
+  std::ofstream(logPath.c_str(), std::ios::out);
+
+  int numScenarios;
+  EXCEL_RC rc = GetNumScenarios(&numScenarios);
+  if (rc != SUCCESS) {
+    LogBatchError(logPath, rc);
+    return ERROR_OCCURED;
+  } else if (numScenarios < 0) {
+    LogBatchError(logPath, AddLocationIfError(EXCEL_INVALID_RETURN,
+                                              GET_NUM_SCENARIOS_NUM));
+    return ERROR_OCCURED;
+  }
+
+  std::vector<ScenarioRun> runs;
+  NomadResult retval = OPTIMAL;
+  for (int s = 0; s < numScenarios; ++s) {
+    ScenarioRun run;
+    rc = ApplyScenario(s, &run.parameters);
+    if (rc != SUCCESS) {
+      LogBatchError(logPath, rc);
+      retval = ERROR_OCCURED;
+      break;
+    }
+    std::ofstream(logPath.c_str(), std::ios::app)
+        << "Scenario " << s + 1 << " of " << numScenarios << std::endl;
+    run.result = RunNomadFromSeeds(GetSeeds(runs, run.parameters),
+                                   &run.summary, true);
+    runs.push_back(run);
+    if (run.result == USER_CANCELLED) {
+      retval = USER_CANCELLED;
+      break;
+    }
+  }
+
+  // One row per scenario, blank for those that weren't solved
+  size_t numVars = 0;
+  for (size_t k = 0; k < runs.size(); ++k) {
+    numVars = std::max(numVars, runs[k].summary.x.size());
+  }
+  const int numColumns = NUM_SCENARIO_COLUMNS + static_cast<int>(numVars);
+  std::vector<double> table(numScenarios * numColumns,
+                            std::numeric_limits<double>::quiet_NaN());
+  for (size_t k = 0; k < runs.size(); ++k) {
+    const SolveSummary& summary = runs[k].summary;
+    double* row = table.data() + k * numColumns;
+    row[SCENARIO_RESULT_COLUMN] = runs[k].result;
+    row[SCENARIO_FEASIBLE_COLUMN] = summary.feasible ? 1 : 0;
+    if (summary.hasSolution) {
+      row[SCENARIO_OBJECTIVE_COLUMN] = summary.objective;
+    }
+    row[SCENARIO_EVALS_COLUMN] = summary.numEvals;
+    row[SCENARIO_SECONDS_COLUMN] = summary.seconds;
+    for (size_t i = 0; i < summary.x.size(); ++i) {
+      row[NUM_SCENARIO_COLUMNS + i] = summary.x[i];
+    }
+  }
+
+  rc = LoadScenarioResults(numScenarios, numColumns, table.data());
+  if (rc != SUCCESS) {
+    LogBatchError(logPath, rc);
+    retval = ERROR_OCCURED;
+  }
+  return retval;
+}
+
+}  // namespace OPENSOLVER
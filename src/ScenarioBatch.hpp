@@ -0,0 +1,45 @@
+// ScenarioBatch.hpp
+// Solves of one model under many scenarios
+//
+// Planners solve the same model under tens or hundreds of scenarios, each
+// with its own input cells, bounds or options. Solving them one call at a
+// time starts every solve cold. A batch asks Excel to apply each scenario in
+// turn, and starts its solve from the best points of the most similar
+// scenarios solved so far, judged by the distance between the values that
+// define the scenarios. The results of all scenarios go back to Excel as one
+// table, and their solves are logged one after another in the log file.
+//
+// Excel can only serve one solve at a time, so scenarios are solved one
+// after another. Each solve can still spread its evaluations over worker
+// threads with PSD_WORKERS or ENUMERATION_WORKERS.
+
+#ifndef SRC_SCENARIOBATCH_H_
+#define SRC_SCENARIOBATCH_H_
+
+#include "NomadInterface.hpp"
+
+namespace OPENSOLVER {
+
+// Columns of the results table, which are followed by the variable values.
+// Scenarios that weren't solved because the batch was cancelled are blank.
+enum ScenarioResultColumn {
+  SCENARIO_RESULT_COLUMN,     // The NomadResult of the solve
+  SCENARIO_FEASIBLE_COLUMN,   // 1 if the solution is feasible, otherwise 0
+  SCENARIO_OBJECTIVE_COLUMN,  // Blank if there is no solution
+  SCENARIO_EVALS_COLUMN,
+  SCENARIO_SECONDS_COLUMN,
+  NUM_SCENARIO_COLUMNS
+};
+
+/**
+ * Solves every scenario defined in Excel and loads the results table
+ *
+ * @return USER_CANCELLED if the user stopped the batch, ERROR_OCCURED if
+ *         Excel failed to apply a scenario or take the results, or OPTIMAL.
+ *         The result of each solve is in the table.
+ */
+NomadResult RunScenarioBatch();
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_SCENARIOBATCH_H_
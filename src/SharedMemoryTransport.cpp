@@ -0,0 +1,373 @@
+// SharedMemoryTransport.cpp
+// POSIX shared-memory ring buffer implementation of Transport
+
+#include "SharedMemoryTransport.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace OPENSOLVER {
+
+const uint32_t SEGMENT_MAGIC = 0x4F534E54;  // "OSNT"
+const uint32_t SEGMENT_VERSION = 1;
+
+// Each frame is [tag, count, payload...] so it needs two extra slots
+const size_t FRAME_HEADER_SLOTS = 2;
+
+// How long to wait on a semaphore before checking the peer is still alive
+const long PEER_CHECK_INTERVAL_NS = 100 * 1000 * 1000;  // NOLINT(runtime/int)
+
+// How often to check whether the host has attached
+const useconds_t HOST_ATTACH_POLL_US = 1000;
+
+#ifdef __APPLE__
+// OS X has no sem_timedwait, so we poll instead. Spin briefly first so that
+// fast replies are picked up without sleeping.
+const int SEM_SPIN_COUNT = 1000;
+const useconds_t SEM_POLL_SLEEP_US = 20;
+const int SEM_POLLS_PER_PEER_CHECK =
+    static_cast<int>(PEER_CHECK_INTERVAL_NS / (SEM_POLL_SLEEP_US * 1000));
+#endif
+
+struct SharedMemoryRing {
+  std::atomic<uint64_t> head;  // Next slot to read
+  std::atomic<uint64_t> tail;  // Next slot to write
+};
+
+struct SharedMemorySegment {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t capacity;
+  std::atomic<int32_t> solverPid;
+  std::atomic<int32_t> hostPid;
+  SharedMemoryRing request;
+  SharedMemoryRing reply;
+};
+
+// Slots start after the header, rounded up to a cache line
+const size_t SEGMENT_HEADER_SIZE = (sizeof(SharedMemorySegment) + 63) & ~63;
+
+size_t GetSegmentSize(size_t capacity) {
+  return SEGMENT_HEADER_SIZE + 2 * capacity * sizeof(double);
+}
+
+double* GetRingSlots(SharedMemorySegment* segment, SharedMemoryRing* ring) {
+  char* slots = reinterpret_cast<char*>(segment) + SEGMENT_HEADER_SIZE;
+  if (ring == &segment->reply) {
+    slots += segment->capacity * sizeof(double);
+  }
+  return reinterpret_cast<double*>(slots);
+}
+
+// Checks whether the process on the other side of the segment is running.
+// A host that hasn't attached yet counts as running until the deadline.
+bool IsPeerAlive(const std::atomic<int32_t>& peerPid,
+                 std::chrono::steady_clock::time_point attachDeadline) {
+  pid_t pid = peerPid.load();
+  if (pid == 0) {
+    return std::chrono::steady_clock::now() < attachDeadline;
+  }
+  return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+std::chrono::steady_clock::time_point GetAttachDeadline() {
+  return std::chrono::steady_clock::now() +
+         std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+             std::chrono::duration<double>(HOST_ATTACH_TIMEOUT_S));
+}
+
+// Waits for the semaphore, giving up if the peer process goes away or never
+// attaches
+bool WaitForPeer(sem_t* sem, const std::atomic<int32_t>& peerPid) {
+  const std::chrono::steady_clock::time_point attachDeadline =
+      GetAttachDeadline();
+#ifdef __APPLE__
+  for (int i = 0; i < SEM_SPIN_COUNT; ++i) {
+    if (sem_trywait(sem) == 0) {
+      return true;
+    }
+  }
+  for (int polls = 1; ; ++polls) {
+    if (sem_trywait(sem) == 0) {
+      return true;
+    } else if (errno != EAGAIN && errno != EINTR) {
+      return false;
+    }
+    usleep(SEM_POLL_SLEEP_US);
+    if (polls % SEM_POLLS_PER_PEER_CHECK == 0 &&
+        !IsPeerAlive(peerPid, attachDeadline)) {
+      return false;
+    }
+  }
+#else
+  for (;;) {
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += PEER_CHECK_INTERVAL_NS;
+    if (deadline.tv_nsec >= 1000000000) {
+      deadline.tv_sec += 1;
+      deadline.tv_nsec -= 1000000000;
+    }
+    if (sem_timedwait(sem, &deadline) == 0) {
+      return true;
+    } else if (errno != ETIMEDOUT && errno != EINTR) {
+      return false;
+    }
+    if (!IsPeerAlive(peerPid, attachDeadline)) {
+      return false;
+    }
+  }
+#endif
+}
+
+std::string GetSemaphoreName(const std::string& name, const char* suffix) {
+  return name + suffix;
+}
+
+SharedMemoryTransport::SharedMemoryTransport(const std::string& name,
+                                             bool owner, size_t size,
+                                             SharedMemorySegment* segment,
+                                             sem_t* requestSem,
+                                             sem_t* replySem) :
+    _name(name),
+    _owner(owner),
+    _size(size),
+    _segment(segment),
+    _requestSem(requestSem),
+    _replySem(replySem) {}
+
+SharedMemoryTransport* SharedMemoryTransport::Create(const std::string& name,
+                                                     size_t capacity) {
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  size_t size = GetSegmentSize(capacity);
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    close(fd);
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  SharedMemorySegment* segment = new (base) SharedMemorySegment();
+  segment->capacity = capacity;
+  segment->solverPid = getpid();
+  segment->hostPid = 0;
+  segment->request.head = 0;
+  segment->request.tail = 0;
+  segment->reply.head = 0;
+  segment->reply.tail = 0;
+  segment->version = SEGMENT_VERSION;
+  segment->magic = SEGMENT_MAGIC;
+
+  // Remove any semaphores left behind by a crashed solver with the same name
+  std::string requestName = GetSemaphoreName(name, ".q");
+  std::string replyName = GetSemaphoreName(name, ".r");
+  sem_unlink(requestName.c_str());
+  sem_unlink(replyName.c_str());
+  sem_t* requestSem = sem_open(requestName.c_str(), O_CREAT | O_EXCL, 0600, 0);
+  sem_t* replySem = sem_open(replyName.c_str(), O_CREAT | O_EXCL, 0600, 0);
+  if (requestSem == SEM_FAILED || replySem == SEM_FAILED) {
+    if (requestSem != SEM_FAILED) sem_close(requestSem);
+    if (replySem != SEM_FAILED) sem_close(replySem);
+    sem_unlink(requestName.c_str());
+    sem_unlink(replyName.c_str());
+    munmap(base, size);
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  return new SharedMemoryTransport(name, true, size, segment, requestSem,
+                                   replySem);
+}
+
+SharedMemoryTransport* SharedMemoryTransport::Open(const std::string& name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < SEGMENT_HEADER_SIZE) {
+    close(fd);
+    return nullptr;
+  }
+  size_t size = static_cast<size_t>(info.st_size);
+
+  void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    return nullptr;
+  }
+
+  // OS X rounds the segment up to a whole page, so it may be larger than the
+  // size given to ftruncate
+  SharedMemorySegment* segment = static_cast<SharedMemorySegment*>(base);
+  if (segment->magic != SEGMENT_MAGIC || segment->version != SEGMENT_VERSION ||
+      size < GetSegmentSize(segment->capacity)) {
+    munmap(base, size);
+    return nullptr;
+  }
+
+  sem_t* requestSem = sem_open(GetSemaphoreName(name, ".q").c_str(), 0);
+  sem_t* replySem = sem_open(GetSemaphoreName(name, ".r").c_str(), 0);
+  if (requestSem == SEM_FAILED || replySem == SEM_FAILED) {
+    if (requestSem != SEM_FAILED) sem_close(requestSem);
+    if (replySem != SEM_FAILED) sem_close(replySem);
+    munmap(base, size);
+    return nullptr;
+  }
+
+  segment->hostPid = getpid();
+  return new SharedMemoryTransport(name, false, size, segment, requestSem,
+                                   replySem);
+}
+
+SharedMemoryTransport::~SharedMemoryTransport() {
+  if (_owner) {
+    // Tell the host to stop serving. There is no reply to wait for.
+    Send(&_segment->request, _requestSem, OP_CLOSE, std::vector<double>());
+  }
+
+  sem_close(_requestSem);
+  sem_close(_replySem);
+  munmap(_segment, _size);
+
+  if (_owner) {
+    sem_unlink(GetSemaphoreName(_name, ".q").c_str());
+    sem_unlink(GetSemaphoreName(_name, ".r").c_str());
+    shm_unlink(_name.c_str());
+  }
+}
+
+bool SharedMemoryTransport::WaitForHost(double timeoutSeconds) {
+  const std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(timeoutSeconds));
+  while (_segment->hostPid.load() == 0) {
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+    usleep(HOST_ATTACH_POLL_US);
+  }
+  return true;
+}
+
+bool SharedMemoryTransport::Send(SharedMemoryRing* ring, sem_t* sem, int tag,
+                                 const std::vector<double>& values) {
+  const uint64_t capacity = _segment->capacity;
+  const uint64_t frameSize = values.size() + FRAME_HEADER_SLOTS;
+  if (frameSize > capacity) {
+    return false;
+  }
+
+  // Wait for the reader to free enough space. Calls are synchronous, so this
+  // only happens if frames are sent ahead of the replies.
+  const uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+  const std::chrono::steady_clock::time_point attachDeadline =
+      GetAttachDeadline();
+  while (tail + frameSize - ring->head.load(std::memory_order_acquire) >
+         capacity) {
+    const std::atomic<int32_t>& peerPid =
+        _owner ? _segment->hostPid : _segment->solverPid;
+    if (!IsPeerAlive(peerPid, attachDeadline)) {
+      return false;
+    }
+    sched_yield();
+  }
+
+  double* slots = GetRingSlots(_segment, ring);
+  slots[tail % capacity] = tag;
+  slots[(tail + 1) % capacity] = static_cast<double>(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    slots[(tail + FRAME_HEADER_SLOTS + i) % capacity] = values[i];
+  }
+  ring->tail.store(tail + frameSize, std::memory_order_release);
+
+  return sem_post(sem) == 0;
+}
+
+bool SharedMemoryTransport::Receive(SharedMemoryRing* ring, sem_t* sem,
+                                    int* tag, std::vector<double>* values) {
+  const std::atomic<int32_t>& peerPid =
+      _owner ? _segment->hostPid : _segment->solverPid;
+  if (!WaitForPeer(sem, peerPid)) {
+    return false;
+  }
+
+  const uint64_t capacity = _segment->capacity;
+  const uint64_t head = ring->head.load(std::memory_order_relaxed);
+  const uint64_t tail = ring->tail.load(std::memory_order_acquire);
+  if (tail - head < FRAME_HEADER_SLOTS) {
+    return false;
+  }
+
+  const double* slots = GetRingSlots(_segment, ring);
+  *tag = static_cast<int>(slots[head % capacity]);
+  const uint64_t count =
+      static_cast<uint64_t>(slots[(head + 1) % capacity]);
+  if (tail - head < count + FRAME_HEADER_SLOTS) {
+    return false;
+  }
+
+  values->resize(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    (*values)[i] = slots[(head + FRAME_HEADER_SLOTS + i) % capacity];
+  }
+  ring->head.store(head + count + FRAME_HEADER_SLOTS,
+                   std::memory_order_release);
+  return true;
+}
+
+EXCEL_RC SharedMemoryTransport::Call(int op, std::vector<double>* values) {
+  if (!Send(&_segment->request, _requestSem, op, *values)) {
+    return EXCEL_API_ERROR;
+  }
+  int rc;
+  if (!Receive(&_segment->reply, _replySem, &rc, values)) {
+    return EXCEL_API_ERROR;
+  }
+  return rc;
+}
+
+EXCEL_RC SharedMemoryTransport::Serve(TransportHandler* handler) {
+  std::vector<double> values;
+  for (;;) {
+    int op;
+    if (!Receive(&_segment->request, _requestSem, &op, &values)) {
+      return EXCEL_API_ERROR;
+    }
+    if (op == OP_CLOSE) {
+      return SUCCESS;
+    }
+    EXCEL_RC rc = handler->Handle(op, &values);
+    if (!Send(&_segment->reply, _replySem, rc, values)) {
+      return EXCEL_API_ERROR;
+    }
+  }
+}
+
+}  // namespace OPENSOLVER
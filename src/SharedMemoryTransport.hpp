@@ -0,0 +1,99 @@
+// SharedMemoryTransport.hpp
+// POSIX shared-memory ring buffer implementation of Transport
+//
+// The solver creates a named shared-memory segment holding two ring buffers
+// of doubles (requests and replies), plus a named semaphore per ring that is
+// posted once per frame. The host attaches to the segment by name and serves
+// requests with a TransportHandler. Only POSIX calls are used, so a stand-in
+// host process can drive the solver the same way on Linux as on OS X.
+
+#ifndef SRC_SHAREDMEMORYTRANSPORT_H_
+#define SRC_SHAREDMEMORYTRANSPORT_H_
+
+#include <semaphore.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Transport.hpp"
+
+namespace OPENSOLVER {
+
+// Default number of double slots in each ring of the segment
+const size_t DEFAULT_RING_CAPACITY = 1 << 20;
+
+// Seconds the host has to attach to a new segment. A solver waiting on a host
+// that never attached gives up after this long rather than hanging.
+const double HOST_ATTACH_TIMEOUT_S = 10;
+
+struct SharedMemorySegment;
+struct SharedMemoryRing;
+
+class SharedMemoryTransport : public Transport {
+ public:
+  /**
+   * Creates a new segment (solver side)
+   *
+   * @param name The name of the segment, must start with '/' and be at most
+   *             29 characters long to fit the OS X limits on names
+   * @param capacity The number of double slots in each ring
+   * @return The new transport, or nullptr if it could not be created
+   */
+  static SharedMemoryTransport* Create(const std::string& name,
+                                       size_t capacity = DEFAULT_RING_CAPACITY);
+
+  /**
+   * Attaches to an existing segment (host side)
+   *
+   * @param name The name passed to Create by the solver
+   * @return The attached transport, or nullptr if it could not be opened
+   */
+  static SharedMemoryTransport* Open(const std::string& name);
+
+  ~SharedMemoryTransport() override;
+
+  /**
+   * Waits for the host to attach to the segment (solver side)
+   *
+   * @param timeoutSeconds How long to wait
+   * @return True once the host has attached, false if it didn't in time
+   */
+  bool WaitForHost(double timeoutSeconds);
+
+  EXCEL_RC Call(int op, std::vector<double>* values) override;
+
+  /**
+   * Serves requests from the solver until it closes the transport (host side)
+   *
+   * @param handler The handler used to answer each request
+   * @return SUCCESS once closed, or EXCEL_API_ERROR if the solver went away
+   */
+  EXCEL_RC Serve(TransportHandler* handler);
+
+  const std::string& GetName() const { return _name; }
+
+ private:
+  SharedMemoryTransport(const std::string& name, bool owner, size_t size,
+                        SharedMemorySegment* segment, sem_t* requestSem,
+                        sem_t* replySem);
+
+  // Writes one frame to the ring and posts its semaphore
+  bool Send(SharedMemoryRing* ring, sem_t* sem, int tag,
+            const std::vector<double>& values);
+
+  // Waits for and reads one frame from the ring
+  bool Receive(SharedMemoryRing* ring, sem_t* sem, int* tag,
+               std::vector<double>* values);
+
+  std::string           _name;
+  bool                  _owner;
+  size_t                _size;
+  SharedMemorySegment*  _segment;
+  sem_t*                _requestSem;
+  sem_t*                _replySem;
+};
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_SHAREDMEMORYTRANSPORT_H_
@@ -0,0 +1,195 @@
+// SolveDaemon.cpp
+// Unix socket implementation of the solve daemon
+
+#include "SolveDaemon.hpp"
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+namespace OPENSOLVER {
+
+// Longest request or reply line we accept
+const size_t MAX_LINE_LENGTH = 256;
+
+// Pending connections queued while a solve is running
+const int LISTEN_BACKLOG = 8;
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+// Makes a socket that won't raise SIGPIPE if the other side goes away
+int CreateSocket() {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+#ifdef SO_NOSIGPIPE
+  if (fd >= 0) {
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+  }
+#endif
+  return fd;
+}
+
+bool GetSocketAddress(const std::string& socketPath, sockaddr_un* address) {
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  if (socketPath.empty() || socketPath.length() >= sizeof(address->sun_path)) {
+    return false;
+  }
+  strncpy(address->sun_path, socketPath.c_str(), sizeof(address->sun_path) - 1);
+  return true;
+}
+
+// Connects to the socket, returning the descriptor or -1 if nobody listens
+int ConnectToDaemon(const std::string& socketPath) {
+  sockaddr_un address;
+  if (!GetSocketAddress(socketPath, &address)) {
+    return -1;
+  }
+  int fd = CreateSocket();
+  if (fd < 0) {
+    return -1;
+  }
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address),
+              sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Reads up to the first newline, which is dropped
+bool ReadLine(int fd, std::string* line) {
+  line->clear();
+  char buffer[MAX_LINE_LENGTH];
+  while (line->length() < MAX_LINE_LENGTH) {
+    ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    } else if (count <= 0) {
+      return false;
+    }
+    line->append(buffer, count);
+    size_t end = line->find('\n');
+    if (end != std::string::npos) {
+      line->erase(end);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WriteLine(int fd, const std::string& line) {
+  std::string data = line + "\n";
+  size_t sent = 0;
+  while (sent < data.length()) {
+    ssize_t count = send(fd, data.c_str() + sent, data.length() - sent,
+                         SEND_FLAGS);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    } else if (count <= 0) {
+      return false;
+    }
+    sent += count;
+  }
+  return true;
+}
+
+int RunSolveDaemon(const std::string& socketPath, NomadResult (*solve)(),
+                   int idleTimeout) {
+  sockaddr_un address;
+  if (!GetSocketAddress(socketPath, &address)) {
+    return EXIT_FAILURE;
+  }
+
+  // Only replace the socket file if no daemon is behind it
+  int existing = ConnectToDaemon(socketPath);
+  if (existing >= 0) {
+    close(existing);
+    return EXIT_FAILURE;
+  }
+  unlink(socketPath.c_str());
+
+  int listenFd = CreateSocket();
+  if (listenFd < 0) {
+    return EXIT_FAILURE;
+  }
+  // Only the user running Excel may ask for solves
+  mode_t oldMask = umask(S_IRWXG | S_IRWXO);
+  int bound = bind(listenFd, reinterpret_cast<sockaddr*>(&address),
+                   sizeof(address));
+  umask(oldMask);
+  if (bound != 0 || listen(listenFd, LISTEN_BACKLOG) != 0) {
+    close(listenFd);
+    return EXIT_FAILURE;
+  }
+
+  bool quit = false;
+  while (!quit) {
+    pollfd listenPoll;
+    listenPoll.fd = listenFd;
+    listenPoll.events = POLLIN;
+    listenPoll.revents = 0;
+    int ready = poll(&listenPoll, 1, idleTimeout > 0 ? idleTimeout * 1000 : -1);
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    } else if (ready <= 0) {
+      break;  // Idle for too long
+    }
+
+    int clientFd = accept(listenFd, nullptr, nullptr);
+    if (clientFd < 0) {
+      continue;
+    }
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(clientFd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+    std::string request;
+    if (ReadLine(clientFd, &request)) {
+      std::ostringstream reply;
+      if (request == "SOLVE") {
+        reply << solve();
+      } else if (request == "VERSION") {
+        reply << VERSION;
+      } else if (request == "QUIT") {
+        reply << 0;
+        quit = true;
+      } else {
+        reply << "ERROR";
+      }
+      WriteLine(clientFd, reply.str());
+    }
+    close(clientFd);
+  }
+
+  close(listenFd);
+  unlink(socketPath.c_str());
+  return EXIT_SUCCESS;
+}
+
+DaemonRequestResult SendDaemonRequest(const std::string& socketPath,
+                                      const std::string& request,
+                                      std::string* reply) {
+  int fd = ConnectToDaemon(socketPath);
+  if (fd < 0) {
+    return DAEMON_NOT_RUNNING;
+  }
+  bool ok = WriteLine(fd, request) && ReadLine(fd, reply);
+  close(fd);
+  return ok ? DAEMON_REPLIED : DAEMON_REPLY_LOST;
+}
+
+}  // namespace OPENSOLVER
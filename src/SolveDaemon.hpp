@@ -0,0 +1,63 @@
+// SolveDaemon.hpp
+// Long-lived solver process that accepts solve requests on a Unix socket
+//
+// Starting a new process for every solve means loading the compiled
+// AppleScript and initialising NOMAD each time, which dominates short solves
+// in scenario sweeps. The daemon stays resident and runs one solve per
+// request, keeping that state between requests. Requests are handled one at a
+// time, as Excel can only serve one solve at once.
+//
+// The protocol is one line of text each way. A client sends one of:
+//   SOLVE    Runs a solve, the reply is the NomadResult
+//   VERSION  The reply is the OpenSolver NOMAD version
+//   QUIT     The reply is 0, after which the daemon exits
+// Anything else is answered with ERROR.
+
+#ifndef SRC_SOLVEDAEMON_H_
+#define SRC_SOLVEDAEMON_H_
+
+#include <string>
+
+#include "NomadInterface.hpp"
+
+namespace OPENSOLVER {
+
+// The daemon exits after this long without a request
+const int DEFAULT_DAEMON_IDLE_TIMEOUT = 30 * 60;  // Seconds
+
+/**
+ * Serves solve requests on a Unix socket until asked to quit
+ *
+ * Fails if another daemon is already listening on the socket. A stale socket
+ * file left by a daemon that died is replaced.
+ * @param socketPath The path of the socket to listen on
+ * @param solve Runs a single solve against the host
+ * @param idleTimeout Seconds without a request before exiting, 0 for never
+ * @return EXIT_SUCCESS after a QUIT request or the idle timeout, or
+ *         EXIT_FAILURE if the socket could not be set up
+ */
+int RunSolveDaemon(const std::string& socketPath, NomadResult (*solve)(),
+                   int idleTimeout = DEFAULT_DAEMON_IDLE_TIMEOUT);
+
+enum DaemonRequestResult {
+  DAEMON_REPLIED,
+  DAEMON_NOT_RUNNING,  // Nothing is listening, so the request wasn't sent
+  DAEMON_REPLY_LOST    // The daemon took the connection but didn't reply
+};
+
+/**
+ * Sends a request to a running daemon and waits for the reply
+ *
+ * @param socketPath The path of the daemon's socket
+ * @param request The request line, without the newline
+ * @param reply Set to the reply line, without the newline
+ * @return DAEMON_REPLIED if the reply arrived. Otherwise, whether the
+ *         request may have been acted on (see DaemonRequestResult).
+ */
+DaemonRequestResult SendDaemonRequest(const std::string& socketPath,
+                                      const std::string& request,
+                                      std::string* reply);
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_SOLVEDAEMON_H_
@@ -0,0 +1,219 @@
+// SolverOptions.cpp
+
+#include "SolverOptions.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace OPENSOLVER {
+
+SolverOptions::SolverOptions() :
+    hiddenConstraintModel(false),
+    hiddenConstraintNeighbours(5),
+    noisyReplication(false),
+    noisyMaxReplicates(5),
+    noisyReplicationBudget(1000),
+    noisyTolerance(0.01),
+    psdWorkers(0),
+    psdSubsetSize(2),
+    psdSubproblemEvals(20),
+    autoTune(false),
+    historyStore(false),
+    historyMemoryMb(256),
+    historyFloatOutputs(true),
+    initialDesign(LATIN_HYPERCUBE_DESIGN),
+    initialDesignSize(0),
+    backgroundSolve(false),
+    constraintAggregation(NO_AGGREGATION),
+    constraintGroups(1),
+    reportViolations(false),
+    useSurrogate(true),
+    enumerationMaxVariables(MAX_ENUMERATION_VARIABLES),
+    enumerationWorkers(1),
+    evaluationBlockSize(16),
+    lipschitzFilter(false),
+    lipschitzNeighbours(10),
+    lipschitzSafety(2),
+    stallWindow(0),
+    stallTolerance(1e-4) {}
+
+// Gets the single value of an entry, throwing if there isn't exactly one
+std::string GetSingleValue(const NOMAD::Parameter_Entry& entry) {
+  if (entry.get_nb_values() != 1) {
+    throw std::runtime_error("invalid parameter: " + entry.get_name());
+  }
+  return *entry.get_values().begin();
+}
+
+// Converts a string to upper case
+std::string ToUpperCase(std::string value) {
+  for (size_t i = 0; i < value.length(); ++i) {
+    value[i] = static_cast<char>(toupper(value[i]));
+  }
+  return value;
+}
+
+// Gets the single value of an entry in upper case, for keyword options
+std::string GetUpperCaseValue(const NOMAD::Parameter_Entry& entry) {
+  return ToUpperCase(GetSingleValue(entry));
+}
+
+std::string GetOptionName(const NOMAD::Parameter_Entry& entry) {
+  return ToUpperCase(entry.get_name());
+}
+
+bool ReadBoolOption(const NOMAD::Parameter_Entry& entry) {
+  std::string value = GetUpperCaseValue(entry);
+  if (value == "YES" || value == "Y" || value == "TRUE" || value == "1") {
+    return true;
+  } else if (value == "NO" || value == "N" || value == "FALSE" ||
+             value == "0") {
+    return false;
+  }
+  throw std::runtime_error("invalid parameter: " + entry.get_name());
+}
+
+int ReadIntOption(const NOMAD::Parameter_Entry& entry, int minValue) {
+  std::string value = GetSingleValue(entry);
+  char* end;
+  long result = strtol(value.c_str(), &end, 10);  // NOLINT(runtime/int)
+  if (*end != '\0' || result < minValue) {
+    throw std::runtime_error("invalid parameter: " + entry.get_name());
+  }
+  return static_cast<int>(result);
+}
+
+double ReadDoubleOption(const NOMAD::Parameter_Entry& entry, double minValue) {
+  std::string value = GetSingleValue(entry);
+  char* end;
+  double result = strtod(value.c_str(), &end);
+  if (*end != '\0' || !(result >= minValue)) {
+    throw std::runtime_error("invalid parameter: " + entry.get_name());
+  }
+  return result;
+}
+
+InitialDesignType ReadInitialDesignOption(
+    const NOMAD::Parameter_Entry& entry) {
+  std::string value = GetUpperCaseValue(entry);
+  if (value == "MIDPOINT") {
+    return MIDPOINT_DESIGN;
+  } else if (value == "LHS") {
+    return LATIN_HYPERCUBE_DESIGN;
+  } else if (value == "SOBOL") {
+    return SOBOL_DESIGN;
+  }
+  throw std::runtime_error("invalid parameter: " + entry.get_name());
+}
+
+ConstraintAggregation ReadAggregationOption(
+    const NOMAD::Parameter_Entry& entry) {
+  std::string value = GetUpperCaseValue(entry);
+  if (value == "NONE") {
+    return NO_AGGREGATION;
+  } else if (value == "MAX") {
+    return MAX_AGGREGATION;
+  } else if (value == "SUM") {
+    return SUM_AGGREGATION;
+  }
+  throw std::runtime_error("invalid parameter: " + entry.get_name());
+}
+
+bool ReadSolverOption(const NOMAD::Parameter_Entry& entry,
+                      SolverOptions* options) {
+  const std::string name = GetOptionName(entry);
+  if (name == "HIDDEN_CONSTRAINT_MODEL") {
+    options->hiddenConstraintModel = ReadBoolOption(entry);
+  } else if (name == "HIDDEN_CONSTRAINT_NEIGHBOURS") {
+    options->hiddenConstraintNeighbours = ReadIntOption(entry, 1);
+  } else if (name == "NOISY_REPLICATION") {
+    options->noisyReplication = ReadBoolOption(entry);
+  } else if (name == "NOISY_MAX_REPLICATES") {
+    options->noisyMaxReplicates = ReadIntOption(entry, 1);
+  } else if (name == "NOISY_REPLICATION_BUDGET") {
+    options->noisyReplicationBudget = ReadIntOption(entry, 0);
+  } else if (name == "NOISY_TOLERANCE") {
+    options->noisyTolerance = ReadDoubleOption(entry, 0);
+  } else if (name == "PSD_WORKERS") {
+    options->psdWorkers = ReadIntOption(entry, 0);
+  } else if (name == "PSD_SUBSET_SIZE") {
+    options->psdSubsetSize = ReadIntOption(entry, 1);
+  } else if (name == "PSD_SUBPROBLEM_EVALS") {
+    options->psdSubproblemEvals = ReadIntOption(entry, 1);
+  } else if (name == "AUTO_TUNE") {
+    options->autoTune = ReadBoolOption(entry);
+  } else if (name == "HISTORY_STORE") {
+    options->historyStore = ReadBoolOption(entry);
+  } else if (name == "HISTORY_MEMORY_MB") {
+    options->historyMemoryMb = ReadIntOption(entry, 1);
+  } else if (name == "HISTORY_FLOAT_OUTPUTS") {
+    options->historyFloatOutputs = ReadBoolOption(entry);
+  } else if (name == "INITIAL_DESIGN") {
+    options->initialDesign = ReadInitialDesignOption(entry);
+  } else if (name == "INITIAL_DESIGN_SIZE") {
+    options->initialDesignSize = ReadIntOption(entry, 0);
+  } else if (name == "BACKGROUND_SOLVE") {
+    options->backgroundSolve = ReadBoolOption(entry);
+  } else if (name == "CONSTRAINT_AGGREGATION") {
+    options->constraintAggregation = ReadAggregationOption(entry);
+  } else if (name == "CONSTRAINT_GROUPS") {
+    options->constraintGroups = ReadIntOption(entry, 1);
+  } else if (name == "REPORT_VIOLATIONS") {
+    options->reportViolations = ReadBoolOption(entry);
+  } else if (name == "USE_SURROGATE") {
+    options->useSurrogate = ReadBoolOption(entry);
+  } else if (name == "ENUMERATION_MAX_VARIABLES") {
+    options->enumerationMaxVariables = std::min(ReadIntOption(entry, 0),
+                                                MAX_ENUMERATION_VARIABLES);
+  } else if (name == "ENUMERATION_WORKERS") {
+    options->enumerationWorkers = ReadIntOption(entry, 1);
+  } else if (name == "EVALUATION_BLOCK_SIZE") {
+    options->evaluationBlockSize = ReadIntOption(entry, 1);
+  } else if (name == "LIPSCHITZ_FILTER") {
+    options->lipschitzFilter = ReadBoolOption(entry);
+  } else if (name == "LIPSCHITZ_NEIGHBOURS") {
+    options->lipschitzNeighbours = ReadIntOption(entry, 2);
+  } else if (name == "LIPSCHITZ_SAFETY") {
+    options->lipschitzSafety = ReadDoubleOption(entry, 1);
+  } else if (name == "STALL_WINDOW") {
+    options->stallWindow = ReadIntOption(entry, 0);
+  } else if (name == "STALL_TOLERANCE") {
+    options->stallTolerance = ReadDoubleOption(entry, 0);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+std::vector<std::string> GetOptionsIgnoredWithoutMads(
+    const SolverOptions& options) {
+  std::vector<std::string> ignored;
+  if (options.hiddenConstraintModel) {
+    ignored.push_back("HIDDEN_CONSTRAINT_MODEL");
+  }
+  if (options.noisyReplication) {
+    ignored.push_back("NOISY_REPLICATION");
+  }
+  if (options.autoTune) {
+    ignored.push_back("AUTO_TUNE");
+  }
+  if (options.historyStore) {
+    ignored.push_back("HISTORY_STORE");
+  }
+  if (options.constraintAggregation != NO_AGGREGATION) {
+    ignored.push_back("CONSTRAINT_AGGREGATION");
+  }
+  if (options.lipschitzFilter) {
+    ignored.push_back("LIPSCHITZ_FILTER");
+  }
+  if (options.stallWindow > 0) {
+    ignored.push_back("STALL_WINDOW");
+  }
+  return ignored;
+}
+
+}  // namespace OPENSOLVER
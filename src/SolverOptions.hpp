@@ -0,0 +1,146 @@
+// SolverOptions.hpp
+// Options that control the OpenSolver side of the solve
+//
+// These are passed from Excel in the same parameter strings as the NOMAD
+// options, and are removed before the remaining strings are given to NOMAD.
+
+#ifndef SRC_SOLVEROPTIONS_H_
+#define SRC_SOLVEROPTIONS_H_
+
+#include <string>
+#include <vector>
+
+#include "nomad.hpp"
+
+#include "BinaryEnumeration.hpp"
+#include "ConstraintAggregator.hpp"
+#include "InitialDesign.hpp"
+
+namespace OPENSOLVER {
+
+struct SolverOptions {
+  SolverOptions();
+
+  // HIDDEN_CONSTRAINT_MODEL: skip points predicted to give Excel errors
+  bool hiddenConstraintModel;
+  // HIDDEN_CONSTRAINT_NEIGHBOURS: neighbours used to predict a failure
+  int hiddenConstraintNeighbours;
+
+  // NOISY_REPLICATION: average repeated reads of points near the incumbent
+  bool noisyReplication;
+  // NOISY_MAX_REPLICATES: most reads of a single point
+  int noisyMaxReplicates;
+  // NOISY_REPLICATION_BUDGET: most extra reads over the whole solve
+  int noisyReplicationBudget;
+  // NOISY_TOLERANCE: relative standard error at which replication stops
+  double noisyTolerance;
+
+  // PSD_WORKERS: worker threads for PSD-MADS, 0 to run plain MADS
+  int psdWorkers;
+  // PSD_SUBSET_SIZE: free variables in each PSD-MADS subproblem
+  int psdSubsetSize;
+  // PSD_SUBPROBLEM_EVALS: evaluation budget of each PSD-MADS subproblem
+  int psdSubproblemEvals;
+
+  // AUTO_TUNE: choose NOMAD options the user didn't give from the model, and
+  // learn from earlier solves in a file next to the log
+  bool autoTune;
+
+  // HISTORY_STORE: keep full outputs in a compact store, NOMAD only gets the
+  // objectives and the largest constraint
+  bool historyStore;
+  // HISTORY_MEMORY_MB: memory cap of the store, dominated points go first
+  int historyMemoryMb;
+  // HISTORY_FLOAT_OUTPUTS: keep outputs other than the incumbent's as floats
+  bool historyFloatOutputs;
+
+  // INITIAL_DESIGN: starting points without a warm start, one of MIDPOINT,
+  // LHS or SOBOL
+  InitialDesignType initialDesign;
+  // INITIAL_DESIGN_SIZE: points in the design, 0 for the number of variables
+  // plus one
+  int initialDesignSize;
+
+  // BACKGROUND_SOLVE: run NOMAD on its own thread, with host calls sent back
+  // to the host thread, which watches for ESC between them. NOMAD doesn't
+  // run during recalculations either way.
+  bool backgroundSolve;
+
+  // CONSTRAINT_AGGREGATION: combine groups of constraints into one output
+  // each, one of NONE, MAX or SUM
+  ConstraintAggregation constraintAggregation;
+  // CONSTRAINT_GROUPS: number of contiguous groups of constraints
+  int constraintGroups;
+  // REPORT_VIOLATIONS: recalculate the solution of an aggregated solve to
+  // list the violated constraints, if the history store doesn't have them
+  bool reportViolations;
+
+  // USE_SURROGATE: use the model's low-fidelity mode, if it has one, to
+  // screen candidates before full evaluations
+  bool useSurrogate;
+
+  // ENUMERATION_MAX_VARIABLES: enumerate all-binary models with at most this
+  // many free variables instead of running MADS, if MAX_BB_EVAL covers every
+  // point, 0 to never enumerate
+  int enumerationMaxVariables;
+  // ENUMERATION_WORKERS: worker threads for the enumeration, at most one of
+  // which evaluates on the host
+  int enumerationWorkers;
+
+  // EVALUATION_BLOCK_SIZE: most points the auto-tuner lets NOMAD hand over
+  // at once, which are reordered to change few variables between
+  // recalculations, 1 to evaluate one point at a time. Without AUTO_TUNE,
+  // blocks are only used if this is given, as BB_MAX_BLOCK_SIZE.
+  int evaluationBlockSize;
+
+  // LIPSCHITZ_FILTER: skip points whose outputs, bounded by the slopes seen
+  // between nearby evaluations, can't improve on the incumbent
+  bool lipschitzFilter;
+  // LIPSCHITZ_NEIGHBOURS: nearby evaluations the slopes are estimated from
+  int lipschitzNeighbours;
+  // LIPSCHITZ_SAFETY: multiple of the largest slope assumed in the bounds
+  double lipschitzSafety;
+
+  // STALL_WINDOW: stop once the incumbent hasn't improved over this many full
+  // evaluations, 0 to never stop for a stall
+  int stallWindow;
+  // STALL_TOLERANCE: smallest relative improvement over the window that
+  // isn't a stall
+  double stallTolerance;
+};
+
+/**
+ * Gets the name of a parameter entry in upper case
+ *
+ * Option names are matched without regard to case, as NOMAD does.
+ * @param entry The parameter entry
+ * @return The name of the entry in upper case
+ */
+std::string GetOptionName(const NOMAD::Parameter_Entry& entry);
+
+/**
+ * Reads a parameter entry into the solver options if it is one of ours
+ *
+ * Throws an exception if the entry is a solver option with an invalid value.
+ * @param entry The parameter entry to read
+ * @param options The options to update
+ * @return True if the entry was a solver option and should not go to NOMAD
+ */
+bool ReadSolverOption(const NOMAD::Parameter_Entry& entry,
+                      SolverOptions* options);
+
+/**
+ * Lists the options that are set but have no effect unless MADS runs
+ *
+ * PSD-MADS subproblems evaluate through their own evaluator and parameters,
+ * and the binary enumeration through neither, so the options that act on
+ * the main evaluator or on NOMAD's parameters are ignored by both.
+ * @param options The solver options
+ * @return The names of the ignored options that are turned on
+ */
+std::vector<std::string> GetOptionsIgnoredWithoutMads(
+    const SolverOptions& options);
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_SOLVEROPTIONS_H_
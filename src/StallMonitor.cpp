@@ -0,0 +1,54 @@
+// StallMonitor.cpp
+
+#include "StallMonitor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+namespace OPENSOLVER {
+
+StallMonitor::StallMonitor(const std::vector<double>& scales, int window,
+                           double tolerance) :
+    _invScales(scales.size()),
+    _window(window),
+    _tolerance(tolerance) {
+  for (size_t i = 0; i < scales.size(); ++i) {
+    _invScales[i] = (scales[i] > 0 && std::isfinite(scales[i]))
+                    ? 1.0 / scales[i] : 1.0;
+  }
+}
+
+bool StallMonitor::Update(const double* bestObjective, double step) {
+  if (bestObjective == nullptr) {
+    _recent.clear();
+    return false;
+  }
+  Record record = {*bestObjective, step};
+  _recent.push_back(record);
+  if (static_cast<int>(_recent.size()) <= _window) {
+    return false;
+  }
+  if (static_cast<int>(_recent.size()) > _window + 1) {
+    _recent.pop_front();
+  }
+
+  double start = _recent.front().objective;
+  double improvement = start - _recent.back().objective;
+  if (improvement > _tolerance * std::max(1.0, std::fabs(start))) {
+    return false;
+  }
+
+  // Growing steps mean successful polls are expanding the mesh
+  const size_t half = _recent.size() / 2;
+  double olderStep = 0;
+  double newerStep = 0;
+  for (size_t k = 0; k < _recent.size(); ++k) {
+    double& largest = (k < half) ? olderStep : newerStep;
+    largest = std::max(largest, _recent[k].step);
+  }
+  return newerStep <= olderStep;
+}
+
+}  // namespace OPENSOLVER
@@ -0,0 +1,69 @@
+// StallMonitor.hpp
+// Detects solves that have stopped improving
+//
+// Solves often run on to MAX_BB_EVAL or MAX_TIME long after the incumbent
+// stopped improving, with every evaluation a full recalculation. The monitor
+// keeps the incumbent objective and the step from the incumbent to each
+// point evaluated over a sliding window of full evaluations, with each
+// variable scaled by its range so one wide variable can't hide the rest.
+// The steps of poll points follow the mesh size, so steps that are no longer
+// growing mean MADS is refining rather than moving. A solve has stalled when
+// the objective improved by less than the tolerance over the window while
+// the steps didn't grow. Nothing stalls before there is a feasible incumbent.
+
+#ifndef SRC_STALLMONITOR_H_
+#define SRC_STALLMONITOR_H_
+
+#include <deque>
+#include <vector>
+
+namespace OPENSOLVER {
+
+class StallMonitor {
+ public:
+  /**
+   * @param scales The range of each variable, used to scale steps
+   * @param window The number of full evaluations improvement is measured over
+   * @param tolerance The smallest improvement over the window, relative to
+   *                  the size of the objective, that isn't a stall
+   */
+  StallMonitor(const std::vector<double>& scales, int window,
+               double tolerance);
+
+  /**
+   * @param i The index of a variable
+   * @param step The change in the variable
+   * @return The change relative to the range of the variable, or unscaled if
+   *         the variable is unbounded
+   */
+  double ScaleStep(int i, double step) const { return step * _invScales[i]; }
+
+  /**
+   * Records a full evaluation
+   *
+   * @param bestObjective The objective of the feasible incumbent, or nullptr
+   *                      if there isn't one
+   * @param step The distance of the point from the incumbent, the largest
+   *             change in any variable as given by ScaleStep
+   * @return True if the solve has stalled
+   */
+  bool Update(const double* bestObjective, double step);
+
+  int GetWindow() const { return _window; }
+  double GetTolerance() const { return _tolerance; }
+
+ private:
+  struct Record {
+    double  objective;
+    double  step;
+  };
+
+  std::vector<double>  _invScales;
+  int                  _window;
+  double               _tolerance;
+  std::deque<Record>   _recent;  // The last window + 1 evaluations
+};
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_STALLMONITOR_H_
@@ -0,0 +1,124 @@
+// StandInHost.hpp
+// In-process stand-in for Excel, implemented in ExcelCallbacks.standin.cpp
+//
+// Linking ExcelCallbacks.standin.cpp instead of a platform implementation
+// lets RunNomad solve a problem defined in C++ without any host, e.g. for
+// benchmarks or to exercise the solver on Linux. Every evaluation is traced
+// so that progress per evaluation can be measured afterwards. As with Excel,
+// the callbacks fail if called from any thread but the one that loaded the
+// problem, so a background solve must dispatch them to the host thread.
+
+#ifndef SRC_STANDINHOST_H_
+#define SRC_STANDINHOST_H_
+
+#include <string>
+#include <vector>
+
+#include "EvaluationBackend.hpp"
+
+namespace OPENSOLVER {
+
+struct StandInProblem {
+  std::string          name;
+  int                  numVars;
+  int                  numObjs;
+  int                  numCons;     // Including the objectives
+  std::vector<double>  lowerBounds;
+  std::vector<double>  upperBounds;
+  std::vector<double>  startingX;
+  std::vector<int>     varTypes;    // See VarType
+  double               optimum;     // Best known objective value
+  std::vector<int>     precheckOutputs;  // See GetPrecheckOutputs
+
+  // Writes the objectives followed by the constraints (feasible if <= 0).
+  // Must be safe to call from several threads at once.
+  void (*evaluate)(const double* x, double* outputs);
+
+  // Low-fidelity version of evaluate, or nullptr if there is none
+  void (*surrogate)(const double* x, double* outputs);
+};
+
+// A scenario of a batch, usually a variant of the other scenarios' problem
+struct StandInScenario {
+  const StandInProblem*  problem;
+  std::vector<double>    parameters;  // Returned by ApplyScenario
+};
+
+struct StandInEvaluation {
+  double  seconds;    // Time since the solve started
+  double  objective;
+  bool    feasible;
+};
+
+/**
+ * Sets up the stand-in host for the next call to RunNomad
+ *
+ * @param problem The problem to serve, which must outlive the solve
+ * @param options The parameter strings returned by GetOptionData
+ * @param logPath The path returned by GetLogFilePath
+ * @param useWarmstart The value returned by GetUseWarmstart
+ * @param latency Seconds each recalculation should take, to mimic a workbook.
+ *                Low-fidelity recalculations take a fiftieth of this.
+ * @param changeLatency Extra seconds per variable changed since the previous
+ *                      recalculation, as Excel only recalculates the cells
+ *                      that depend on changed variables
+ */
+void StartStandInSolve(const StandInProblem* problem,
+                       const std::vector<std::string>& options,
+                       const std::string& logPath, bool useWarmstart,
+                       double latency, double changeLatency = 0);
+
+/**
+ * Sets up the stand-in host for the next call to RunScenarioBatch
+ *
+ * @param scenarios The scenarios to serve, which must outlive the batch
+ * @param options The parameter strings returned by GetOptionData
+ * @param logPath The path returned by GetLogFilePath
+ * @param useWarmstart The value returned by GetUseWarmstart
+ * @param latency Seconds each recalculation should take
+ * @param changeLatency Extra seconds per changed variable, see
+ *                      StartStandInSolve
+ */
+void StartStandInBatch(const std::vector<StandInScenario>* scenarios,
+                       const std::vector<std::string>& options,
+                       const std::string& logPath, bool useWarmstart,
+                       double latency, double changeLatency = 0);
+
+/**
+ * Moves the stand-in host into a separate process for the current solve
+ *
+ * Forks a host process that attaches to a SharedMemoryTransport and serves
+ * the recalculations of the problem given to StartStandInSolve, as Excel
+ * does on OS X. The host callbacks then go over the transport, so the
+ * transport can be exercised on Linux. Call after StartStandInSolve.
+ * @return False if the transport or the host process couldn't be set up
+ */
+bool StartStandInTransport();
+
+/**
+ * Closes the transport and waits for the host process to exit
+ *
+ * @return False if the host process failed
+ */
+bool StopStandInTransport();
+
+// Gets the table last given to LoadScenarioResults, one vector per row
+std::vector<std::vector<double> > GetStandInScenarioResults();
+
+// Gets every evaluation made since StartStandInSolve, in order
+std::vector<StandInEvaluation> GetStandInTrace();
+
+// Gets the variable values last written with UpdateVars
+std::vector<double> GetStandInVars();
+
+/**
+ * Creates an independent stand-in backend for a worker thread
+ *
+ * Can be installed with SetBackendFactory so that workers evaluate in
+ * parallel instead of queueing to the host thread.
+ */
+EvaluationBackend* CreateStandInBackend(int workerIndex);
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_STANDINHOST_H_
@@ -0,0 +1,100 @@
+// Transport.cpp
+// Evaluation callbacks implemented on top of a Transport
+
+#include "Transport.hpp"
+
+#include <vector>
+
+namespace OPENSOLVER {
+
+EXCEL_RC TransportCheckForEscapeKeypress(Transport* transport) {
+  std::vector<double> values;
+  EXCEL_RC rc = transport->Call(OP_CHECK_ABORT, &values);
+  if (rc == SUCCESS) {
+    if (values.size() != 1) {
+      rc = EXCEL_INVALID_RETURN;
+    } else if (values[0] != 0) {
+      rc = ESC_ABORT;
+    }
+  }
+  return AddLocationIfError(rc, CHECK_ESC_PRESS_NUM);
+}
+
+EXCEL_RC TransportUpdateVars(Transport* transport, double* newVars,
+                             int numVars, const double* bestSolution,
+                             bool feasibility) {
+  // Payload is the new variables followed by the status fields:
+  // [x_1, ..., x_n, hasBestSolution, bestSolution, feasibility]
+  std::vector<double> values(newVars, newVars + numVars);
+  values.push_back(bestSolution == nullptr ? 0 : 1);
+  values.push_back(bestSolution == nullptr ? 0 : *bestSolution);
+  values.push_back(feasibility ? 1 : 0);
+
+  EXCEL_RC rc = transport->Call(OP_UPDATE_VARS, &values);
+  if (rc == SUCCESS && !values.empty()) {
+    rc = EXCEL_INVALID_RETURN;
+  }
+  return AddLocationIfError(rc, UPDATE_VARS_NUM);
+}
+
+EXCEL_RC TransportRecalculateValues(Transport* transport) {
+  std::vector<double> values;
+  EXCEL_RC rc = transport->Call(OP_RECALCULATE_VALUES, &values);
+  if (rc == SUCCESS && !values.empty()) {
+    rc = EXCEL_INVALID_RETURN;
+  }
+  return AddLocationIfError(rc, RECALCULATE_VALUES_NUM);
+}
+
+EXCEL_RC TransportGetConstraintValues(Transport* transport, int numCons,
+                                      double* newCons) {
+  // Error cells are sent as NaN by the host, so they pass straight through
+  std::vector<double> values;
+  EXCEL_RC rc = transport->Call(OP_GET_CONSTRAINT_VALUES, &values);
+  if (rc == SUCCESS) {
+    if (values.size() == static_cast<size_t>(numCons)) {
+      for (int i = 0; i < numCons; ++i) {
+        newCons[i] = values[i];
+      }
+    } else {
+      rc = EXCEL_INVALID_RETURN;
+    }
+  }
+  return AddLocationIfError(rc, GET_CONSTRAINT_VALUES_NUM);
+}
+
+EXCEL_RC TransportRecalculatePrecheck(Transport* transport) {
+  std::vector<double> values;
+  EXCEL_RC rc = transport->Call(OP_RECALCULATE_PRECHECK, &values);
+  if (rc == SUCCESS && !values.empty()) {
+    rc = EXCEL_INVALID_RETURN;
+  }
+  return AddLocationIfError(rc, RECALCULATE_PRECHECK_NUM);
+}
+
+EXCEL_RC TransportGetPrecheckValues(Transport* transport, int numPrecheck,
+                                    double* values) {
+  std::vector<double> reply;
+  EXCEL_RC rc = transport->Call(OP_GET_PRECHECK_VALUES, &reply);
+  if (rc == SUCCESS) {
+    if (reply.size() == static_cast<size_t>(numPrecheck)) {
+      for (int i = 0; i < numPrecheck; ++i) {
+        values[i] = reply[i];
+      }
+    } else {
+      rc = EXCEL_INVALID_RETURN;
+    }
+  }
+  return AddLocationIfError(rc, GET_PRECHECK_VALUES_NUM);
+}
+
+EXCEL_RC TransportRecalculateSurrogate(Transport* transport) {
+  std::vector<double> values;
+  EXCEL_RC rc = transport->Call(OP_RECALCULATE_SURROGATE, &values);
+  if (rc == SUCCESS && !values.empty()) {
+    rc = EXCEL_INVALID_RETURN;
+  }
+  return AddLocationIfError(rc, RECALCULATE_SURROGATE_NUM);
+}
+
+}  // namespace OPENSOLVER
@@ -0,0 +1,77 @@
+// Transport.hpp
+// Transport-neutral message layer between the solver process and the host
+//
+// Each request is a packed array of doubles tagged with an opcode. The host
+// replies with a return code and another packed array of doubles. The
+// functions below implement the evaluation callbacks from ExcelCallbacks.hpp
+// on top of any Transport, so a platform only needs to provide the channel.
+
+#ifndef SRC_TRANSPORT_H_
+#define SRC_TRANSPORT_H_
+
+#include <vector>
+
+#include "ExcelCallbacks.hpp"
+
+namespace OPENSOLVER {
+
+// Should match the opcodes handled by the host side of the transport
+enum TransportOp {
+  OP_CHECK_ABORT = 1,
+  OP_UPDATE_VARS = 2,
+  OP_RECALCULATE_VALUES = 3,
+  OP_GET_CONSTRAINT_VALUES = 4,
+  OP_CLOSE = 5,
+  OP_RECALCULATE_PRECHECK = 6,
+  OP_GET_PRECHECK_VALUES = 7,
+  OP_RECALCULATE_SURROGATE = 8
+};
+
+class Transport {
+ public:
+  virtual ~Transport() {}
+
+  /**
+   * Sends a request to the host and blocks until the reply arrives
+   *
+   * @param op The opcode of the request (see TransportOp)
+   * @param values The request payload, replaced with the reply payload
+   * @return The return code sent back by the host
+   */
+  virtual EXCEL_RC Call(int op, std::vector<double>* values) = 0;
+};
+
+/**
+ * Handles requests on the host side of a transport
+ */
+class TransportHandler {
+ public:
+  virtual ~TransportHandler() {}
+
+  /**
+   * Processes a single request from the solver
+   *
+   * @param op The opcode of the request (see TransportOp)
+   * @param values The request payload, to be replaced with the reply payload
+   * @return The return code to send back to the solver
+   */
+  virtual EXCEL_RC Handle(int op, std::vector<double>* values) = 0;
+};
+
+// Implementations of the evaluation callbacks over a transport. Each one has
+// the same contract as the ExcelCallbacks.hpp function of the same name.
+EXCEL_RC TransportCheckForEscapeKeypress(Transport* transport);
+EXCEL_RC TransportUpdateVars(Transport* transport, double* newVars,
+                             int numVars, const double* bestSolution,
+                             bool feasibility);
+EXCEL_RC TransportRecalculateValues(Transport* transport);
+EXCEL_RC TransportGetConstraintValues(Transport* transport, int numCons,
+                                      double* newCons);
+EXCEL_RC TransportRecalculatePrecheck(Transport* transport);
+EXCEL_RC TransportGetPrecheckValues(Transport* transport, int numPrecheck,
+                                    double* values);
+EXCEL_RC TransportRecalculateSurrogate(Transport* transport);
+
+}  // namespace OPENSOLVER
+
+#endif  // SRC_TRANSPORT_H_